@@ -0,0 +1,103 @@
+#include "bench.h"
+
+// apply() against the visitor path it replaced: visit the bounds and copy-on-write one material instance per tile.
+
+class stCopyOnWrite : public stVisitor
+{
+public:
+    stCopyOnWrite(stMaterials& store, stTable<stLabel, int32_t>& bases, std::vector<int32_t>& instances, int32_t value, int16_t amount) :
+        m_store(store) , m_bases(bases) , m_instances(instances) , m_value(value) , m_amount(amount) , m_tile(0) {}
+
+    void onTile(stLocation const& transform, stMaterial const& material, stBehavior const& behavior) override {
+        int32_t* base = m_bases.find(material.label);
+
+        if(!base)
+        {
+            int32_t const handle = m_store.acquire();
+            m_store.store(handle, material);
+            base = &m_bases.insert(material.label, handle);
+        }
+
+        stMaterial copy = material;
+        copy.base = *base;
+        copy.values[m_value] = std::clamp<int16_t>(copy.values[m_value].value + m_amount, 0, stMaterial::Values[m_value].limit);
+
+        if(m_tile == m_instances.size())
+            m_instances.push_back(0);
+
+        int32_t const previous = m_instances[m_tile];
+        m_instances[m_tile++] = m_store.instance(copy);
+
+        if(previous)
+            m_store.release(previous);
+    }
+
+private:
+    stMaterials& m_store;
+    stTable<stLabel, int32_t>& m_bases;
+    std::vector<int32_t>& m_instances;
+    int32_t m_value;
+    int16_t m_amount;
+    size_t m_tile;
+};
+
+int main()
+{
+    int32_t constexpr Islands = 16384;
+
+    std::vector<stRequest> const requests = stBench::grid(Islands, stSettings::CellsIsland, stBench::materials(3));
+
+    stSubtile world("bench");
+    world.parse(requests.data(), requests.size());
+
+    float const extent = stBench::extent(Islands);
+    stBounds const whole(stLocation(0, 0.0f, 0.0f), stLocation(0, extent, extent));
+
+    stMaterials store(1024);
+    stTable<stLabel, int32_t> bases;
+    std::vector<int32_t> instances;
+
+    store.acquire();
+
+    stBench::report("visitor copy-on-write, whole world", stBench::Runs, [&]() {
+        return stBench::time([&]() {
+            stCopyOnWrite copy(store, bases, instances, stMaterial::Temperature, 1);
+            world.visit(copy, whole);
+            store.reclaim(static_cast<int32_t>(instances.size()));
+        });
+    }, static_cast<double>(requests.size()));
+
+    stBench::report("apply, whole world", stBench::Runs, [&]() {
+        return stBench::time([&]() { world.apply(whole, stMaterial::Temperature, stValue::Add, 1); });
+    }, static_cast<double>(requests.size()));
+
+    auto window = [extent](int32_t i) {
+        float const x = static_cast<float>((i * 97) % static_cast<int32_t>(extent - 8.0f));
+        float const y = static_cast<float>((i * 61) % static_cast<int32_t>(extent - 8.0f));
+
+        return stBounds(stLocation(0, x, y), stLocation(0, x + 8.0f, y + 8.0f));
+    };
+
+    stBench::report("visitor copy-on-write, 1024 windows of 8x8", stBench::Runs, [&]() {
+        return stBench::time([&]() {
+            for(int32_t i = 0; i < 1024; i++)
+            {
+                std::vector<int32_t> local;
+                stCopyOnWrite copy(store, bases, local, stMaterial::Hitpoints, -1);
+                world.visit(copy, window(i));
+
+                for(int32_t handle : local)
+                    store.release(handle);
+            }
+
+            store.reclaim(INT32_MAX);
+        });
+    });
+
+    stBench::report("apply, 1024 windows of 8x8", stBench::Runs, [&]() {
+        return stBench::time([&]() {
+            for(int32_t i = 0; i < 1024; i++)
+                world.apply(window(i), stMaterial::Hitpoints, stValue::Add, -1);
+        });
+    });
+}
@@ -0,0 +1,62 @@
+#include "bench.h"
+
+// Batch acquire/release on stPool, and bulk parse() of 1M tiles against single parses.
+
+int main()
+{
+    int32_t constexpr Count = 1 << 20;
+
+    std::vector<int32_t> handles(Count);
+
+    stBench::report("stPool acquire one at a time", stBench::Runs, [&]() {
+        stPool<stKey> pool(1024);
+
+        return stBench::time([&]() {
+            for(int32_t& handle : handles)
+            {
+                handle = 0;
+                pool.acquire(handle);
+            }
+        });
+    }, Count);
+
+    stBench::report("stPool acquire batch", stBench::Runs, [&]() {
+        stPool<stKey> pool(1024);
+        return stBench::time([&]() { pool.acquire(Count, handles.data()); });
+    }, Count);
+
+    stBench::report("stPool release one at a time", stBench::Runs, [&]() {
+        stPool<stKey> pool(1024);
+        pool.acquire();
+        pool.acquire(Count - 1, handles.data() + 1);
+
+        return stBench::time([&]() {
+            for(int32_t i = 1; i < Count; i++)
+                pool.release(handles[i]);
+        });
+    }, Count - 1);
+
+    stBench::report("stPool release batch", stBench::Runs, [&]() {
+        stPool<stKey> pool(1024);
+        pool.acquire();
+        pool.acquire(Count - 1, handles.data() + 1);
+
+        return stBench::time([&]() { pool.release(handles.data() + 1, Count - 1); });
+    }, Count - 1);
+
+    std::vector<stRequest> const requests = stBench::grid(Count / (stSettings::CellsIsland * stSettings::CellsIsland), stSettings::CellsIsland, stBench::materials(3));
+
+    stBench::report("parse 1M tiles one at a time", stBench::Runs, [&requests]() {
+        stSubtile world("bench");
+
+        return stBench::time([&]() {
+            for(stRequest const& request : requests)
+                world.parse(request);
+        });
+    }, static_cast<double>(requests.size()));
+
+    stBench::report("parse 1M tiles in bulk", stBench::Runs, [&requests]() {
+        stSubtile world("bench");
+        return stBench::time([&]() { world.parse(requests.data(), requests.size()); });
+    }, static_cast<double>(requests.size()));
+}
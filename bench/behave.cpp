@@ -0,0 +1,16 @@
+#include "bench.h"
+
+// step() cost of 1M tiles that all carry a heater or a decay behavior.
+
+int main()
+{
+    std::vector<stRequest> requests = stBench::grid(16384, stSettings::CellsIsland, stBench::materials(3));
+
+    for(size_t i = 0; i < requests.size(); i++)
+        requests[i].behavior = (i % 2) ? stBehavior(stBehavior::Heater, 80, 1) : stBehavior(stBehavior::Decay, 1000, 1);
+
+    stSubtile world("bench");
+    world.parse(requests.data(), requests.size());
+
+    stBench::report("step with 1M behaviors", stBench::Runs, [&world]() { return stBench::time([&world]() { world.step(); }); }, static_cast<double>(requests.size()));
+}
@@ -0,0 +1,87 @@
+#ifndef SUBTILE_BENCH_H
+#define SUBTILE_BENCH_H
+
+// Each benchmark is a standalone main. From the repository root:
+//     g++ -std=c++17 -O2 -march=native -DNDEBUG -pthread -Isrc/subtile bench/<name>.cpp src/subtile/subtile.cpp -o <name>
+
+#include "subtile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class stBench
+{
+public:
+    using stClock = std::chrono::steady_clock;
+
+    static constexpr int32_t Runs = 5;
+
+    template<class Function>
+    static double time(Function&& function) {
+        stClock::time_point const start = stClock::now();
+        function();
+        return std::chrono::duration<double>(stClock::now() - start).count();
+    }
+
+    template<class Function>
+    static double report(char const* name, int32_t runs, Function&& function, double items = 0.0) {
+        std::vector<double> samples;
+
+        for(int32_t i = 0; i < runs; i++)
+            samples.push_back(function());
+
+        std::sort(samples.begin(), samples.end());
+        std::printf("%-44s min %9.3f ms   median %9.3f ms", name, samples.front() * 1e3, samples[samples.size() / 2] * 1e3);
+
+        if(items > 0.0)
+            std::printf("   %8.2f M/s", items / samples.front() * 1e-6);
+
+        std::printf("\n");
+
+        return samples.front();
+    }
+
+    static std::vector<stMaterial> materials(int32_t count) {
+        std::vector<stMaterial> created;
+
+        for(int32_t i = 0; i < count; i++)
+            created.emplace_back(stLabel(std::string("m") + std::to_string(i)));
+
+        return created;
+    }
+
+    static int32_t side(int32_t islands) {
+        return static_cast<int32_t>(std::ceil(std::sqrt(static_cast<double>(islands))));
+    }
+
+    static float extent(int32_t islands) {
+        return static_cast<float>(side(islands) * stSettings::SizeIsland);
+    }
+
+    // Fills `islands` islands on a square grid, one island after another, with cells x cells tiles each.
+    static std::vector<stRequest> grid(int32_t islands, int32_t cells, std::vector<stMaterial> const& materials) {
+        std::vector<stRequest> requests;
+        requests.reserve(static_cast<size_t>(islands) * cells * cells);
+
+        for(int32_t island = 0; island < islands; island++)
+        {
+            float const x = static_cast<float>((island % side(islands)) * stSettings::SizeIsland);
+            float const y = static_cast<float>((island / side(islands)) * stSettings::SizeIsland);
+
+            for(int32_t cell = 0; cell < cells * cells; cell++)
+            {
+                stRequest request(0, x + (cell % cells + 0.5f) * stSettings::SizeCell, y + (cell / cells + 0.5f) * stSettings::SizeCell);
+                request.material = materials[island % materials.size()];
+                requests.push_back(request);
+            }
+        }
+
+        return requests;
+    }
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include "bench.h"
+
+#include <thread>
+
+// stConcurrentPool acquire/release throughput from 1 to 32 producer threads.
+
+int main()
+{
+    int32_t constexpr Count = 1 << 20;
+    int32_t constexpr Rounds = 16;
+
+    for(int32_t threads = 1; threads <= 32; threads *= 2)
+    {
+        char name[64];
+        std::snprintf(name, sizeof(name), "acquire+release, %d threads", threads);
+
+        stBench::report(name, stBench::Runs, [threads]() {
+            stConcurrentPool<stKey> pool(1024);
+            pool.acquire();
+
+            return stBench::time([&pool, threads]() {
+                std::vector<std::thread> workers;
+
+                for(int32_t t = 0; t < threads; t++)
+                {
+                    workers.emplace_back([&pool, threads]() {
+                        std::vector<int32_t> owned(Count / Rounds / threads);
+
+                        for(int32_t round = 0; round < Rounds; round++)
+                        {
+                            for(int32_t& handle : owned)
+                            {
+                                handle = 0;
+                                pool.acquire(handle);
+                            }
+
+                            for(int32_t handle : owned)
+                                pool.release(handle);
+                        }
+                    });
+                }
+
+                for(std::thread& worker : workers)
+                    worker.join();
+            });
+        }, Count);
+    }
+
+    std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+}
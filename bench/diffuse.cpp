@@ -0,0 +1,31 @@
+#include "bench.h"
+
+// Diffusion throughput in active islands per second across world sizes, on a single worker.
+
+int main()
+{
+    stMaterial hot("hot");
+    hot.temperature() = stMaterial::Values[stMaterial::Temperature].limit;
+
+    stMaterial cold("cold");
+    cold.temperature() = 0;
+
+    std::vector<stMaterial> const materials = { hot, cold };
+
+    for(int32_t islands : { 1024, 4096, 16384, 65536 })
+    {
+        std::vector<stRequest> const requests = stBench::grid(islands, stSettings::CellsIsland, materials);
+
+        stSubtile world("bench");
+        world.threads(1);
+        world.parse(requests.data(), requests.size());
+        world.step();
+
+        size_t const active = world.active();
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "step, %d islands, %zu active", islands, active);
+
+        stBench::report(name, stBench::Runs, [&world]() { return stBench::time([&world]() { world.step(); }); }, static_cast<double>(active));
+    }
+}
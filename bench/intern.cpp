@@ -0,0 +1,43 @@
+#include "bench.h"
+
+// Material interning: parse() of 1M tiles cycling through stSettings::PoolMaterial registered materials.
+
+int main()
+{
+    int32_t constexpr Islands = 16384;
+
+    std::vector<stMaterial> const materials = stBench::materials(stSettings::PoolMaterial);
+    std::vector<stRequest> requests = stBench::grid(Islands, stSettings::CellsIsland, materials);
+
+    for(size_t i = 0; i < requests.size(); i++)
+        requests[i].material = materials[i % materials.size()];
+
+    stBench::report("register 4096 materials", stBench::Runs, [&]() {
+        stSubtile fresh("bench");
+
+        return stBench::time([&]() {
+            for(stMaterial const& material : materials)
+            {
+                stRequest request(0, 0.0f, 0.0f);
+                request.material = material;
+                fresh.parse(request);
+            }
+        });
+    }, static_cast<double>(materials.size()));
+
+    stSubtile world("bench");
+
+    for(size_t i = 0; i < materials.size(); i++)
+        world.parse(requests[i]);
+
+    stBench::report("parse 1M tiles over 4096 materials", stBench::Runs, [&]() {
+        return stBench::time([&]() {
+            for(stRequest const& request : requests)
+                world.parse(request);
+        });
+    }, static_cast<double>(requests.size()));
+
+    stBench::report("bulk parse 1M tiles over 4096 materials", stBench::Runs, [&]() {
+        return stBench::time([&]() { world.parse(requests.data(), requests.size()); });
+    }, static_cast<double>(requests.size()));
+}
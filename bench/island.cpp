@@ -0,0 +1,37 @@
+#include "bench.h"
+
+// Island directory: creating and looking up islands through parse() at 1k, 100k and 1M islands.
+
+int main()
+{
+    std::vector<stMaterial> const materials = stBench::materials(3);
+
+    for(int32_t islands : { 1000, 100000, 1000000 })
+    {
+        std::vector<stRequest> const requests = stBench::grid(islands, 1, materials);
+
+        char name[64];
+
+        std::snprintf(name, sizeof(name), "insert %d islands", islands);
+        stBench::report(name, 3, [&requests]() {
+            stSubtile world("bench");
+            return stBench::time([&]() {
+                for(stRequest const& request : requests)
+                    world.parse(request);
+            });
+        }, islands);
+
+        stSubtile world("bench");
+
+        for(stRequest const& request : requests)
+            world.parse(request);
+
+        std::snprintf(name, sizeof(name), "lookup %d islands", islands);
+        stBench::report(name, 3, [&]() {
+            return stBench::time([&]() {
+                for(stRequest const& request : requests)
+                    world.parse(request);
+            });
+        }, islands);
+    }
+}
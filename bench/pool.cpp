@@ -0,0 +1,121 @@
+#include "bench.h"
+
+// Chunked generational stPool against the fixed int16 array pool it replaced.
+
+template<class Struct>
+class stFixedPool
+{
+public:
+    stFixedPool(int16_t capacity) : m_capacity(capacity) , m_poolSize(0) , m_freeSize(0) {
+        m_pool.reset(new Struct[m_capacity]);
+        m_free.reset(new int16_t[m_capacity]);
+    }
+
+    Struct& acquire(int16_t& handle) {
+        assert(handle == 0);
+        assert(m_freeSize || (m_poolSize < m_capacity));
+
+        if(m_freeSize)
+        {
+            m_freeSize--;
+            handle = m_free[m_freeSize];
+        }
+        else
+        {
+            handle = m_poolSize;
+            m_poolSize++;
+        }
+
+        return m_pool[handle];
+    }
+
+    void release(int16_t handle) {
+        if((handle <= 0) || (handle >= m_poolSize))
+            throw stException("stFixedPool::release");
+
+        m_free[m_freeSize++] = handle;
+    }
+
+    Struct& at(int16_t handle) {
+        assert((handle >= 0) && (handle < m_poolSize));
+        return m_pool[handle];
+    }
+
+private:
+    int16_t const m_capacity;
+    int16_t m_poolSize;
+    int16_t m_freeSize;
+    std::unique_ptr<Struct[]> m_pool;
+    std::unique_ptr<int16_t[]> m_free;
+};
+
+int main()
+{
+    int32_t constexpr Count = INT16_MAX;
+    int32_t constexpr Rounds = 32;
+
+    int64_t sum = 0;
+
+    stBench::report("fixed int16 pool, acquire/at/release", stBench::Runs, [&sum]() {
+        stFixedPool<stKey> pool(Count);
+        std::vector<int16_t> handles(Count - 1, 0);
+
+        int16_t reserved = 0;
+        pool.acquire(reserved);
+
+        return stBench::time([&]() {
+            for(int32_t round = 0; round < Rounds; round++)
+            {
+                for(int16_t& handle : handles)
+                {
+                    handle = 0;
+                    pool.acquire(handle) = stKey(handle, round, 0);
+                }
+
+                for(int16_t handle : handles)
+                    sum += pool.at(handle).xyz[0];
+
+                for(int16_t handle : handles)
+                    pool.release(handle);
+            }
+        });
+    }, static_cast<double>(Count - 1) * Rounds);
+
+    stBench::report("stPool, acquire/at/release", stBench::Runs, [&sum]() {
+        stPool<stKey> pool(1024);
+        std::vector<int32_t> handles(Count - 1, 0);
+
+        pool.acquire();
+
+        return stBench::time([&]() {
+            for(int32_t round = 0; round < Rounds; round++)
+            {
+                for(int32_t& handle : handles)
+                {
+                    handle = 0;
+                    pool.acquire(handle) = stKey(handle, round, 0);
+                }
+
+                for(int32_t handle : handles)
+                    sum += pool.at(handle).xyz[0];
+
+                for(int32_t handle : handles)
+                    pool.release(handle);
+            }
+        });
+    }, static_cast<double>(Count - 1) * Rounds);
+
+    stBench::report("stPool past the int16 ceiling, 1M acquire", stBench::Runs, [&sum]() {
+        stPool<stKey> pool(1024);
+
+        return stBench::time([&]() {
+            for(int32_t i = 0; i < (1 << 20); i++)
+            {
+                int32_t handle = 0;
+                sum += pool.acquire(handle).xyz[0] = i;
+            }
+        });
+    }, 1 << 20);
+
+    std::printf("checksum %lld\n", static_cast<long long>(sum));
+}
@@ -0,0 +1,32 @@
+#include "bench.h"
+
+#include <thread>
+
+// step() on the worker pool: 16384 active islands at 1, 2, 4, ... threads up to the host core count.
+
+int main()
+{
+    int32_t constexpr Islands = 16384;
+
+    stMaterial hot("hot");
+    hot.temperature() = stMaterial::Values[stMaterial::Temperature].limit;
+
+    stMaterial cold("cold");
+    cold.temperature() = 0;
+
+    std::vector<stRequest> const requests = stBench::grid(Islands, stSettings::CellsIsland, { hot, cold });
+    int32_t const threads = std::max(1, static_cast<int32_t>(std::thread::hardware_concurrency()));
+
+    for(int32_t count = 1; count <= threads; count *= 2)
+    {
+        stSubtile world("bench");
+        world.threads(count);
+        world.parse(requests.data(), requests.size());
+        world.step();
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "step, %d threads", count);
+
+        stBench::report(name, stBench::Runs, [&world]() { return stBench::time([&world]() { world.step(); }); }, static_cast<double>(world.active()));
+    }
+}
@@ -0,0 +1,63 @@
+#include "bench.h"
+
+#include <random>
+
+// Bounded visits over 16384 full islands, built in grid order and in shuffled request order.
+
+class stCounter : public stVisitor
+{
+public:
+    void onTile(stLocation const& transform, stMaterial const& material, stBehavior const& behavior) override { tiles++; }
+
+    size_t tiles = 0;
+};
+
+int main()
+{
+    int32_t constexpr Islands = 16384;
+
+    std::vector<stRequest> const ordered = stBench::grid(Islands, stSettings::CellsIsland, stBench::materials(3));
+    std::vector<stRequest> shuffled = ordered;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(7));
+
+    std::vector<stRequest> const* const worlds[] = { &ordered, &shuffled };
+
+    float const extent = stBench::extent(Islands);
+    size_t tiles = 0;
+
+    for(std::vector<stRequest> const* requests : worlds)
+    {
+        stSubtile world("bench");
+
+        for(stRequest const& request : *requests)
+            world.parse(request);
+
+        char name[64];
+
+        std::snprintf(name, sizeof(name), "%s world, 1024 windows of 16x16", (requests == &ordered) ? "ordered" : "shuffled");
+        stBench::report(name, stBench::Runs, [&]() {
+            return stBench::time([&]() {
+                for(int32_t i = 0; i < 1024; i++)
+                {
+                    float const x = static_cast<float>((i * 97) % static_cast<int32_t>(extent - 16.0f));
+                    float const y = static_cast<float>((i * 61) % static_cast<int32_t>(extent - 16.0f));
+
+                    stCounter counter;
+                    world.visit(counter, stBounds(stLocation(0, x, y), stLocation(0, x + 16.0f, y + 16.0f)));
+                    tiles += counter.tiles;
+                }
+            });
+        });
+
+        std::snprintf(name, sizeof(name), "%s world, whole world", (requests == &ordered) ? "ordered" : "shuffled");
+        stBench::report(name, stBench::Runs, [&]() {
+            return stBench::time([&]() {
+                stCounter counter;
+                world.visit(counter);
+                tiles += counter.tiles;
+            });
+        });
+    }
+
+    std::printf("%zu tiles visited\n", tiles);
+}
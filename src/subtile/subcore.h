@@ -5,14 +5,26 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <array>
 #include <algorithm>
 #include <exception>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
 
 #include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <cassert>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 class stSettings
 {
 public:
@@ -21,6 +33,9 @@ public:
     static constexpr int32_t SizeIsland = 4;
     static constexpr int32_t SizeRegion = 128;
 
+    static constexpr int32_t CellsIsland = 8;
+    static constexpr float SizeCell = static_cast<float>(SizeIsland) / CellsIsland;
+
     static constexpr uint8_t StoragePackage = 128;
     static constexpr uint8_t StorageIsland = 64;
     static constexpr uint8_t StorageLabel = 12;
@@ -28,6 +43,20 @@ public:
     static constexpr size_t PoolMaterial = 4096;
     static constexpr size_t PoolBehavior = 2048;
     static constexpr size_t PoolIsland = 64;
+    static constexpr size_t PoolRegion = 64;
+
+    static constexpr int32_t BudgetCompact = 4096;
+    static constexpr int32_t HolesCompact = 1024;
+    static constexpr int32_t BudgetReclaim = 1024;
+    static constexpr int32_t BatchParse = 4096;
+
+    static constexpr int32_t ShiftDiffusion = 3;
+    static constexpr int32_t QuietIsland = 8;
+    static constexpr int32_t ThreadsStep = 0;
+
+    static constexpr float RateStep = 30.0f;
+    static constexpr float BudgetStep = 0.010f;
+    static constexpr int32_t BacklogStep = 8;
 };
 
 class stException final : public std::exception
@@ -45,6 +74,14 @@ private:
 class stValue
 {
 public:
+    enum Operations {
+        Assign,
+        Add,
+        Minimum,
+        Maximum,
+        Count
+    };
+
     stValue()=default;
     stValue(int16_t value) : value(value) {}
 
@@ -60,33 +97,295 @@ public:
     constexpr stValueMeta()=default;
     constexpr stValueMeta(char const* name, int16_t index, int16_t limit) : name(name) , index(index) , limit(limit)  {}
 
+    template<size_t Size>
+    static constexpr bool ordered(std::array<stValueMeta, Size> const& metas) {
+        for(size_t i = 0; i < Size; i++)
+        {
+            if((metas[i].index != static_cast<int16_t>(i)) || (metas[i].limit <= 0))
+                return false;
+        }
+
+        return true;
+    }
+
     char const* const name;
     int16_t const index;
     int16_t const limit;
 };
 
+class stSimd
+{
+public:
+    static constexpr int32_t Lanes = 16;
+
+    static int32_t select(int16_t const* column, int16_t const* live, int32_t count, int16_t lower, int16_t upper, int32_t* rows) {
+        int32_t found = 0;
+        int32_t i = 0;
+
+#if defined(__AVX2__)
+        __m256i const lowerVector = _mm256_set1_epi16(lower);
+        __m256i const upperVector = _mm256_set1_epi16(upper);
+
+        for(; i + 16 <= count; i += 16)
+        {
+            __m256i const values = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(column + i));
+            __m256i const outside = _mm256_or_si256(_mm256_cmpgt_epi16(lowerVector, values), _mm256_cmpgt_epi16(values, upperVector));
+
+            uint32_t bits = _mm256_movemask_epi8(_mm256_andnot_si256(outside, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(live + i)))) & 0x55555555u;
+
+            for(; bits; bits &= bits - 1)
+                rows[found++] = i + (__builtin_ctz(bits) >> 1);
+        }
+#elif defined(__SSE2__)
+        __m128i const lowerVector = _mm_set1_epi16(lower);
+        __m128i const upperVector = _mm_set1_epi16(upper);
+
+        for(; i + 8 <= count; i += 8)
+        {
+            __m128i const values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(column + i));
+            __m128i const outside = _mm_or_si128(_mm_cmpgt_epi16(lowerVector, values), _mm_cmpgt_epi16(values, upperVector));
+
+            uint32_t bits = _mm_movemask_epi8(_mm_andnot_si128(outside, _mm_loadu_si128(reinterpret_cast<__m128i const*>(live + i)))) & 0x5555u;
+
+            for(; bits; bits &= bits - 1)
+                rows[found++] = i + (__builtin_ctz(bits) >> 1);
+        }
+#endif
+
+        for(; i < count; i++)
+        {
+            if(live[i] && (column[i] >= lower) && (column[i] <= upper))
+                rows[found++] = i;
+        }
+
+        return found;
+    }
+
+    static void update(int16_t* column, int16_t const* live, int32_t count, int32_t operation, int16_t amount, int16_t lower, int16_t upper) {
+        int32_t i = 0;
+
+#if defined(__AVX2__)
+        __m256i const amountVector = _mm256_set1_epi16(amount);
+        __m256i const lowerVector = _mm256_set1_epi16(lower);
+        __m256i const upperVector = _mm256_set1_epi16(upper);
+
+        for(; i + 16 <= count; i += 16)
+        {
+            __m256i const values = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(column + i));
+            __m256i const mask = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(live + i));
+            __m256i result = values;
+
+            switch(operation)
+            {
+                case stValue::Assign: result = amountVector; break;
+                case stValue::Add: result = _mm256_adds_epi16(values, amountVector); break;
+                case stValue::Minimum: result = _mm256_min_epi16(values, amountVector); break;
+                case stValue::Maximum: result = _mm256_max_epi16(values, amountVector); break;
+            }
+
+            result = _mm256_min_epi16(_mm256_max_epi16(result, lowerVector), upperVector);
+            result = _mm256_or_si256(_mm256_and_si256(mask, result), _mm256_andnot_si256(mask, values));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(column + i), result);
+        }
+#elif defined(__SSE2__)
+        __m128i const amountVector = _mm_set1_epi16(amount);
+        __m128i const lowerVector = _mm_set1_epi16(lower);
+        __m128i const upperVector = _mm_set1_epi16(upper);
+
+        for(; i + 8 <= count; i += 8)
+        {
+            __m128i const values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(column + i));
+            __m128i const mask = _mm_loadu_si128(reinterpret_cast<__m128i const*>(live + i));
+            __m128i result = values;
+
+            switch(operation)
+            {
+                case stValue::Assign: result = amountVector; break;
+                case stValue::Add: result = _mm_adds_epi16(values, amountVector); break;
+                case stValue::Minimum: result = _mm_min_epi16(values, amountVector); break;
+                case stValue::Maximum: result = _mm_max_epi16(values, amountVector); break;
+            }
+
+            result = _mm_min_epi16(_mm_max_epi16(result, lowerVector), upperVector);
+            result = _mm_or_si128(_mm_and_si128(mask, result), _mm_andnot_si128(mask, values));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(column + i), result);
+        }
+#endif
+
+        for(; i < count; i++)
+        {
+            if(live[i])
+                column[i] = apply(column[i], operation, amount, lower, upper);
+        }
+    }
+
+    static int16_t apply(int16_t value, int32_t operation, int16_t amount, int16_t lower, int16_t upper) {
+        int32_t result = value;
+
+        switch(operation)
+        {
+            case stValue::Assign: result = amount; break;
+            case stValue::Add: result = value + amount; break;
+            case stValue::Minimum: result = std::min(value, amount); break;
+            case stValue::Maximum: result = std::max(value, amount); break;
+        }
+
+        return static_cast<int16_t>(std::clamp<int32_t>(result, lower, upper));
+    }
+
+    static constexpr int32_t Halo = stSettings::CellsIsland + 2;
+
+    static void diffuse(int16_t const* grid, int16_t const* live, int16_t* cells, int32_t shift) {
+        static_assert(stSettings::CellsIsland == 8, "diffuse processes one island row per 128-bit vector");
+
+        int32_t constexpr offsets[4] = { -1, 1, -Halo, Halo };
+
+        for(int32_t y = 0; y < stSettings::CellsIsland; y++)
+        {
+            int16_t const* const row = grid + (y + 1) * Halo + 1;
+            int16_t const* const mask = live + (y + 1) * Halo + 1;
+
+#if defined(__SSE2__)
+            __m128i const center = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row));
+            __m128i const count = _mm_cvtsi32_si128(shift);
+            __m128i const bias = _mm_set1_epi16(static_cast<int16_t>((1 << shift) - 1));
+            __m128i sum = _mm_setzero_si128();
+
+            for(int32_t offset : offsets)
+            {
+                __m128i const neighbour = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + offset));
+                __m128i const neighbourMask = _mm_loadu_si128(reinterpret_cast<__m128i const*>(mask + offset));
+                __m128i const difference = _mm_sub_epi16(neighbour, center);
+                __m128i const flux = _mm_sra_epi16(_mm_add_epi16(difference, _mm_and_si128(_mm_srai_epi16(difference, 15), bias)), count);
+
+                sum = _mm_add_epi16(sum, _mm_and_si128(flux, neighbourMask));
+            }
+
+            __m128i const delta = _mm_and_si128(sum, _mm_loadu_si128(reinterpret_cast<__m128i const*>(mask)));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(cells + y * stSettings::CellsIsland), _mm_add_epi16(center, delta));
+#else
+            for(int32_t x = 0; x < stSettings::CellsIsland; x++)
+            {
+                int16_t sum = 0;
+
+                for(int32_t offset : offsets)
+                    sum += ((row[x + offset] - row[x]) / (1 << shift)) & mask[x + offset];
+
+                cells[y * stSettings::CellsIsland + x] = row[x] + (sum & mask[x]);
+            }
+#endif
+        }
+    }
+};
+
+class stSymbols
+{
+public:
+    static uint32_t intern(std::string_view const& text) {
+        stSymbols& symbols = instance();
+        std::lock_guard<std::mutex> lock(symbols.m_mutex);
+
+        auto const found = symbols.m_symbols.find(text);
+
+        if(found != symbols.m_symbols.end())
+            return found->second;
+
+        uint32_t const symbol = static_cast<uint32_t>(symbols.m_texts.size());
+
+        symbols.m_texts.emplace_back(text);
+        symbols.m_symbols.emplace(symbols.m_texts.back(), symbol);
+
+        return symbol;
+    }
+
+    static char const* str(uint32_t symbol) {
+        stSymbols& symbols = instance();
+        std::lock_guard<std::mutex> lock(symbols.m_mutex);
+
+        return symbols.m_texts[symbol].c_str();
+    }
+
+private:
+    stSymbols() {
+        m_texts.emplace_back();
+        m_symbols.emplace(m_texts.back(), 0);
+    }
+
+    static stSymbols& instance() {
+        static stSymbols symbols;
+        return symbols;
+    }
+
+    std::mutex m_mutex;
+    std::deque<std::string> m_texts;
+    std::unordered_map<std::string_view, uint32_t> m_symbols;
+};
+
 class stLabel
 {
 public:
-    stLabel() : m_data { '\n' } {}
+    stLabel() : m_symbol(0) {}
 
     stLabel(std::string_view const& stringView) {
         assert(stringView.size() < stSettings::StorageLabel);
-        std::strcpy(m_data, stringView.data());
+        m_symbol = stSymbols::intern(stringView);
     }
 
     stLabel(char const* cString) {
         assert(std::strlen(cString) < stSettings::StorageLabel);
-        std::strcpy(m_data, cString);
+        m_symbol = stSymbols::intern(cString);
     }
 
-    char const* str() const { return m_data; }
+    char const* str() const { return stSymbols::str(m_symbol); }
+    uint32_t symbol() const { return m_symbol; }
+
+    uint64_t hash() const {
+        uint64_t value = m_symbol * 0x9E3779B97F4A7C15ull;
+        return value ^ (value >> 32);
+    }
 
-    bool operator == (stLabel const& right) const { return std::strcmp(m_data, right.m_data) == 0; }
-    bool operator != (stLabel const& right) const { return std::strcmp(m_data, right.m_data) != 0; }
+    bool operator == (stLabel const& right) const { return m_symbol == right.m_symbol; }
+    bool operator != (stLabel const& right) const { return m_symbol != right.m_symbol; }
 
 private:
-    char m_data[stSettings::StorageLabel];
+    uint32_t m_symbol;
+};
+
+class stKey
+{
+public:
+    stKey()=default;
+    stKey(int32_t x, int32_t y, int32_t z) : xyz{ x, y, z } {}
+
+    uint64_t hash() const {
+        uint64_t value = (static_cast<uint64_t>(static_cast<uint32_t>(xyz[0])) << 32) ^ static_cast<uint32_t>(xyz[1]);
+        value ^= static_cast<uint64_t>(static_cast<uint32_t>(xyz[2])) * 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    uint64_t morton() const {
+        static auto constexpr spread = [](int32_t value) {
+            uint64_t bits = static_cast<uint64_t>(value + (1 << 20)) & 0x1FFFFF;
+            bits = (bits | (bits << 32)) & 0x001F00000000FFFFull;
+            bits = (bits | (bits << 16)) & 0x001F0000FF0000FFull;
+            bits = (bits | (bits << 8)) & 0x100F00F00F00F00Full;
+            bits = (bits | (bits << 4)) & 0x10C30C30C30C30C3ull;
+            bits = (bits | (bits << 2)) & 0x1249249249249249ull;
+            return bits;
+        };
+
+        return spread(xyz[0]) | (spread(xyz[1]) << 1) | (spread(xyz[2]) << 2);
+    }
+
+    bool operator == (stKey const& right) const { return (xyz[0] == right.xyz[0]) && (xyz[1] == right.xyz[1]) && (xyz[2] == right.xyz[2]); }
+    bool operator != (stKey const& right) const { return !(*this == right); }
+
+    int32_t xyz[3];
 };
 
 class stVector
@@ -178,7 +477,7 @@ public:
         std::memcpy(&nameSize, &m_data[0], sizeof(uint8_t));
         std::memcpy(nameBuffer, &m_data[1], nameSize);
 
-        if((nameSize != name.size()) || (name != nameBuffer))
+        if((nameSize != name.size()) || (name != std::string_view(nameBuffer, nameSize)))
             throw stException("stPackage::decode");
 
         uint8_t const dataPart = sizeof(uint8_t) + nameSize;
@@ -190,7 +489,7 @@ public:
         m_size = sizeof(uint8_t) * 2 + nameSize + dataSize;
     }
 
-    std::string_view name() const { return m_size ? "empty" : std::string_view(reinterpret_cast<char const*>(&m_data[1]), m_data[0]); }
+    std::string_view name() const { return !m_size ? "empty" : std::string_view(reinterpret_cast<char const*>(&m_data[1]), m_data[0]); }
     uint8_t const* data() const { return m_data; }
     uint8_t size() const { return m_size; }
 
@@ -203,66 +502,710 @@ template<class Struct>
 class stPool
 {
 public:
-    stPool(int16_t capacity) : m_capacity(capacity) , m_poolSize(0) , m_freeSize(0) {
-        m_pool.reset(new Struct[m_capacity]);
-        m_free.reset(new int16_t[m_capacity]);
+    static constexpr int32_t BitsIndex = 22;
+    static constexpr int32_t MaskIndex = (1 << BitsIndex) - 1;
+    static constexpr int32_t MaskGeneration = (1 << (31 - BitsIndex)) - 1;
+
+    static int32_t index(int32_t handle) { return handle & MaskIndex; }
+    static int32_t generation(int32_t handle) { return handle >> BitsIndex; }
+
+    stPool(int32_t chunk) : m_shift(0) , m_poolSize(0) {
+        while((1 << m_shift) < chunk)
+            m_shift++;
     }
 
-    Struct& acquire(int16_t& handle) {
+    Struct& acquire(int32_t& handle) {
         assert(handle == 0);
-        assert(m_freeSize || (m_poolSize < m_capacity));
 
-        if(m_freeSize)
+        int32_t slot = 0;
+
+        if(!m_free.empty())
         {
-            m_freeSize--;
-            handle = m_free[m_freeSize];
+            slot = m_free.back();
+            m_free.pop_back();
         }
         else
         {
-            handle = m_poolSize;
+            if(m_poolSize > MaskIndex)
+                throw stException("stPool::acquire");
+
+            if((m_poolSize >> m_shift) == static_cast<int32_t>(m_chunks.size()))
+                m_chunks.emplace_back(new Struct[1 << m_shift]);
+
+            slot = m_poolSize;
             m_poolSize++;
+
+            if(slot == static_cast<int32_t>(m_generations.size()))
+                m_generations.push_back(0);
         }
 
-        return m_pool[handle];
+        handle = (m_generations[slot] << BitsIndex) | slot;
+
+        return at(handle);
     }
 
     Struct& acquire() {
-        int16_t handle = 0;
-        acquire(handle);
-
-        return at(handle);
+        int32_t handle = 0;
+        return acquire(handle);
     }
 
-    void release(int16_t handle) {
-        if((handle <= 0) || (handle >= m_poolSize))
+    void acquire(int32_t count, int32_t* handles) {
+        int32_t const recycled = std::min(count, static_cast<int32_t>(m_free.size()));
+        int32_t const fresh = count - recycled;
+
+        if(m_poolSize + fresh > MaskIndex + 1)
             throw stException("stPool::acquire");
 
-        m_free[m_freeSize++] = handle;
+        for(int32_t i = 0; i < recycled; i++)
+        {
+            int32_t const slot = m_free[m_free.size() - 1 - i];
+            handles[i] = (m_generations[slot] << BitsIndex) | slot;
+        }
+
+        m_free.resize(m_free.size() - recycled);
+
+        while(m_poolSize + fresh > (static_cast<int32_t>(m_chunks.size()) << m_shift))
+            m_chunks.emplace_back(new Struct[1 << m_shift]);
+
+        if(m_poolSize + fresh > static_cast<int32_t>(m_generations.size()))
+            m_generations.resize(m_poolSize + fresh, 0);
+
+        for(int32_t i = 0; i < fresh; i++)
+            handles[recycled + i] = (m_generations[m_poolSize + i] << BitsIndex) | (m_poolSize + i);
+
+        m_poolSize += fresh;
+    }
+
+    void release(int32_t handle) {
+        if((index(handle) == 0) || !valid(handle))
+            throw stException("stPool::release");
+
+        m_generations[index(handle)] = (m_generations[index(handle)] + 1) & MaskGeneration;
+        m_free.push_back(index(handle));
+    }
+
+    void release(int32_t const* handles, int32_t count) {
+        m_free.reserve(m_free.size() + count);
+
+        for(int32_t i = 0; i < count; i++)
+            release(handles[i]);
+    }
+
+    template<class Remap>
+    int32_t compact(int32_t budget, Remap&& remap) {
+        std::vector<bool> dead(m_poolSize, false);
+
+        for(int32_t slot : m_free)
+            dead[slot] = true;
+
+        std::sort(m_free.begin(), m_free.end());
+
+        int32_t const poolSize = m_poolSize;
+        size_t hole = 0;
+
+        while(true)
+        {
+            while((m_poolSize > 1) && dead[m_poolSize - 1])
+                m_poolSize--;
+
+            if((budget <= 0) || (hole == m_free.size()) || (m_free[hole] >= m_poolSize))
+                break;
+
+            int32_t const from = m_poolSize - 1;
+            int32_t const to = m_free[hole++];
+
+            element(to) = std::move(element(from));
+            remap((m_generations[from] << BitsIndex) | from, (m_generations[to] << BitsIndex) | to);
+
+            m_generations[from] = (m_generations[from] + 1) & MaskGeneration;
+            dead[from] = true;
+            dead[to] = false;
+            budget--;
+        }
+
+        m_free.erase(m_free.begin(), m_free.begin() + hole);
+        m_free.erase(std::lower_bound(m_free.begin(), m_free.end(), m_poolSize), m_free.end());
+        std::reverse(m_free.begin(), m_free.end());
+
+        m_chunks.resize(((m_poolSize - 1) >> m_shift) + 1);
+
+        return poolSize - m_poolSize;
+    }
+
+    template<class Function>
+    void each(Function&& function) {
+        std::vector<bool> dead(m_poolSize, false);
+
+        for(int32_t slot : m_free)
+            dead[slot] = true;
+
+        for(int32_t slot = 0; slot < m_poolSize; slot++)
+        {
+            if(!dead[slot])
+                function((m_generations[slot] << BitsIndex) | slot, element(slot));
+        }
+    }
+
+    int32_t handle(int32_t slot) const { return (m_generations[slot] << BitsIndex) | slot; }
+
+    int32_t size() const { return m_poolSize - static_cast<int32_t>(m_free.size()); }
+    int32_t holes() const { return static_cast<int32_t>(m_free.size()); }
+
+    bool valid(int32_t handle) const {
+        return (handle >= 0) && (index(handle) < m_poolSize) && (m_generations[index(handle)] == generation(handle));
+    }
+
+    Struct const& at(int32_t handle) const {
+        if(!valid(handle))
+            throw stException("stPool::at");
+
+        return m_chunks[index(handle) >> m_shift][index(handle) & ((1 << m_shift) - 1)];
+    }
+
+    Struct& at(int32_t handle) {
+        if(!valid(handle))
+            throw stException("stPool::at");
+
+        return element(index(handle));
+    }
+
+private:
+    Struct& element(int32_t slot) { return m_chunks[slot >> m_shift][slot & ((1 << m_shift) - 1)]; }
+
+    int32_t m_shift;
+    int32_t m_poolSize;
+    std::vector<int32_t> m_free;
+    std::vector<int32_t> m_generations;
+    std::vector<std::unique_ptr<Struct[]>> m_chunks;
+};
+
+template<class Struct>
+class stConcurrentPool
+{
+public:
+    static constexpr int32_t BitsIndex = stPool<Struct>::BitsIndex;
+    static constexpr int32_t MaskIndex = stPool<Struct>::MaskIndex;
+    static constexpr int32_t MaskGeneration = stPool<Struct>::MaskGeneration;
+
+    static int32_t index(int32_t handle) { return handle & MaskIndex; }
+    static int32_t generation(int32_t handle) { return handle >> BitsIndex; }
+
+    stConcurrentPool(int32_t chunk) : m_shift(0) , m_poolSize(0) , m_head(0) {
+        while((1 << m_shift) < chunk)
+            m_shift++;
+
+        m_chunks.reset(new std::atomic<stChunk*>[(MaskIndex >> m_shift) + 1]);
+
+        for(int32_t i = 0; i <= (MaskIndex >> m_shift); i++)
+            m_chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    stConcurrentPool(stConcurrentPool const&)=delete;
+
+   ~stConcurrentPool() {
+        for(int32_t i = 0; i <= (MaskIndex >> m_shift); i++)
+            delete m_chunks[i].load(std::memory_order_relaxed);
+    }
+
+    Struct& acquire(int32_t& handle) {
+        assert(handle == 0);
+
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        int32_t slot = 0;
+
+        while(true)
+        {
+            slot = static_cast<int32_t>(head & 0xFFFFFFFF);
+
+            if(!slot)
+                break;
+
+            uint64_t const next = ((head >> 32) + 1) << 32 | static_cast<uint32_t>(chunk(slot)->next[offset(slot)].load(std::memory_order_relaxed));
+
+            if(m_head.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire))
+                break;
+        }
+
+        if(!slot)
+        {
+            slot = m_poolSize.fetch_add(1, std::memory_order_relaxed);
+
+            if(slot > MaskIndex)
+                throw stException("stConcurrentPool::acquire");
+
+            if(!m_chunks[slot >> m_shift].load(std::memory_order_acquire))
+            {
+                stChunk* expected = nullptr;
+                stChunk* const created = new stChunk(1 << m_shift);
+
+                if(!m_chunks[slot >> m_shift].compare_exchange_strong(expected, created, std::memory_order_acq_rel))
+                    delete created;
+            }
+        }
+
+        handle = (chunk(slot)->generations[offset(slot)].load(std::memory_order_acquire) << BitsIndex) | slot;
+
+        return chunk(slot)->elements[offset(slot)];
+    }
+
+    Struct& acquire() {
+        int32_t handle = 0;
+        return acquire(handle);
+    }
+
+    void release(int32_t handle) {
+        int32_t expected = generation(handle);
+        int32_t const slot = index(handle);
+
+        if((handle <= 0) || (slot == 0) || (slot >= m_poolSize.load(std::memory_order_acquire)) ||
+           !chunk(slot)->generations[offset(slot)].compare_exchange_strong(expected, (expected + 1) & MaskGeneration, std::memory_order_acq_rel))
+            throw stException("stConcurrentPool::release");
+
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+
+        while(true)
+        {
+            chunk(slot)->next[offset(slot)].store(static_cast<int32_t>(head & 0xFFFFFFFF), std::memory_order_relaxed);
+
+            if(m_head.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | static_cast<uint32_t>(slot), std::memory_order_release, std::memory_order_relaxed))
+                break;
+        }
+    }
+
+    bool valid(int32_t handle) const {
+        stChunk* const found = (handle >= 0) ? chunk(index(handle)) : nullptr;
+        return found && (found->generations[offset(index(handle))].load(std::memory_order_acquire) == generation(handle));
+    }
+
+    Struct& at(int32_t handle) {
+        if(!valid(handle))
+            throw stException("stConcurrentPool::at");
+
+        return chunk(index(handle))->elements[offset(index(handle))];
+    }
+
+private:
+    struct stChunk
+    {
+        stChunk(int32_t size) : elements(new Struct[size]) , generations(new std::atomic<int32_t>[size]) , next(new std::atomic<int32_t>[size]) {
+            for(int32_t i = 0; i < size; i++)
+            {
+                generations[i].store(0, std::memory_order_relaxed);
+                next[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        std::unique_ptr<Struct[]> elements;
+        std::unique_ptr<std::atomic<int32_t>[]> generations;
+        std::unique_ptr<std::atomic<int32_t>[]> next;
+    };
+
+    stChunk* chunk(int32_t slot) const { return m_chunks[slot >> m_shift].load(std::memory_order_acquire); }
+    int32_t offset(int32_t slot) const { return slot & ((1 << m_shift) - 1); }
+
+    int32_t m_shift;
+    std::atomic<int32_t> m_poolSize;
+    std::atomic<uint64_t> m_head;
+    std::unique_ptr<std::atomic<stChunk*>[]> m_chunks;
+};
+
+template<class Key, class Value>
+class stTable
+{
+public:
+    stTable(size_t capacity = 16) : m_size(0) {
+        size_t slots = 16;
+
+        while(slots < capacity * 2)
+            slots <<= 1;
+
+        m_slots.resize(slots);
+    }
+
+    Value* find(Key const& key) {
+        return const_cast<Value*>(static_cast<stTable const*>(this)->find(key));
+    }
+
+    Value const* find(Key const& key) const {
+        size_t const mask = m_slots.size() - 1;
+
+        for(size_t i = key.hash() & mask; m_slots[i].used; i = (i + 1) & mask)
+        {
+            if(m_slots[i].key == key)
+                return &m_slots[i].value;
+        }
+
+        return nullptr;
+    }
+
+    Value& insert(Key const& key, Value const& value) {
+        if((m_size + 1) * 2 > m_slots.size())
+            grow();
+
+        size_t const mask = m_slots.size() - 1;
+        size_t i = key.hash() & mask;
+
+        while(m_slots[i].used)
+        {
+            if(m_slots[i].key == key)
+                return m_slots[i].value = value;
+
+            i = (i + 1) & mask;
+        }
+
+        m_slots[i].key = key;
+        m_slots[i].value = value;
+        m_slots[i].used = true;
+        m_size++;
+
+        return m_slots[i].value;
+    }
+
+    bool erase(Key const& key) {
+        size_t const mask = m_slots.size() - 1;
+        size_t i = key.hash() & mask;
+
+        while(m_slots[i].used && (m_slots[i].key != key))
+            i = (i + 1) & mask;
+
+        if(!m_slots[i].used)
+            return false;
+
+        for(size_t j = (i + 1) & mask; m_slots[j].used; j = (j + 1) & mask)
+        {
+            size_t const home = m_slots[j].key.hash() & mask;
+
+            if(((j > i) && ((home <= i) || (home > j))) || ((j < i) && (home <= i) && (home > j)))
+            {
+                m_slots[i] = m_slots[j];
+                i = j;
+            }
+        }
+
+        m_slots[i].used = false;
+        m_size--;
+
+        return true;
+    }
+
+    size_t size() const { return m_size; }
+
+private:
+    struct stSlot
+    {
+        Key key;
+        Value value;
+        bool used = false;
+    };
+
+    void grow() {
+        std::vector<stSlot> slots(m_slots.size() * 2);
+        std::swap(slots, m_slots);
+
+        m_size = 0;
+
+        for(stSlot const& slot : slots)
+        {
+            if(slot.used)
+                insert(slot.key, slot.value);
+        }
+    }
+
+    std::vector<stSlot> m_slots;
+    size_t m_size;
+};
+
+template<class Value>
+class stWheel
+{
+public:
+    static constexpr int32_t BitsLevel = 6;
+    static constexpr int32_t Slots = 1 << BitsLevel;
+    static constexpr int32_t Levels = 4;
+
+    stWheel() : m_tick(0) , m_size(0) {}
+
+    void schedule(uint64_t deadline, Value const& value) {
+        place(std::max(deadline, m_tick + 1), value);
+        m_size++;
+    }
+
+    template<class Function>
+    void advance(Function&& expired) {
+        m_tick++;
+
+        for(int32_t level = 1; level < Levels; level++)
+        {
+            if(m_tick & ((1ull << (BitsLevel * level)) - 1))
+                break;
+
+            std::vector<stEntry> cascaded;
+            std::swap(cascaded, m_slots[level][(m_tick >> (BitsLevel * level)) & (Slots - 1)]);
+
+            for(stEntry const& entry : cascaded)
+                place(entry.deadline, entry.value);
+        }
+
+        m_expiring.clear();
+        std::swap(m_expiring, m_slots[0][m_tick & (Slots - 1)]);
+
+        for(stEntry const& entry : m_expiring)
+        {
+            if(entry.deadline > m_tick)
+            {
+                place(entry.deadline, entry.value);
+                continue;
+            }
+
+            m_size--;
+            expired(entry.value);
+        }
     }
 
-    void release(Struct& pointer) {
-        int16_t handle = &pointer - &m_pool[0];
-        release(handle);
+    uint64_t tick() const { return m_tick; }
+    size_t size() const { return m_size; }
+
+private:
+    struct stEntry
+    {
+        uint64_t deadline;
+        Value value;
+    };
+
+    void place(uint64_t deadline, Value const& value) {
+        uint64_t const distance = deadline ^ m_tick;
+        int32_t level = 0;
+
+        while((level < Levels - 1) && (distance >> (BitsLevel * (level + 1))))
+            level++;
+
+        m_slots[level][(deadline >> (BitsLevel * level)) & (Slots - 1)].push_back({ deadline, value });
     }
 
-    Struct const& at(int16_t handle) const {
-        assert((handle >= 0) && (handle < m_poolSize));
-        return m_pool[handle];
+    std::vector<stEntry> m_slots[Levels][Slots];
+    std::vector<stEntry> m_expiring;
+    uint64_t m_tick;
+    size_t m_size;
+};
+
+class stWorkers
+{
+public:
+    stWorkers(int32_t threads) : m_queues(std::max(threads, 1)) , m_context(nullptr) , m_invoke(nullptr) , m_pending(0) , m_generation(0) , m_stopping(false) {
+        for(int32_t i = 1; i < static_cast<int32_t>(m_queues.size()); i++)
+            m_threads.emplace_back(&stWorkers::work, this, i);
     }
 
-    Struct& at(int16_t handle) {
-        assert((handle >= 0) && (handle < m_poolSize));
-        return m_pool[handle];
+    stWorkers(stWorkers const&)=delete;
+
+   ~stWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_wake.notify_all();
+
+        for(std::thread& thread : m_threads)
+            thread.join();
+    }
+
+    template<class Function>
+    void run(int32_t count, Function&& function) {
+        if(count <= 0)
+            return;
+
+        if(m_threads.empty())
+        {
+            for(int32_t task = 0; task < count; task++)
+                function(task);
+
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_context = &function;
+            m_invoke = [](void* context, int32_t task) { (*static_cast<std::remove_reference_t<Function>*>(context))(task); };
+            m_pending.store(count, std::memory_order_release);
+            m_generation++;
+        }
+
+        for(int32_t task = 0; task < count; task++)
+        {
+            stQueue& queue = m_queues[task % m_queues.size()];
+
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(task);
+        }
+
+        m_wake.notify_all();
+
+        drain(0);
+
+        while(m_pending.load(std::memory_order_acquire))
+            std::this_thread::yield();
     }
 
+    int32_t size() const { return static_cast<int32_t>(m_queues.size()); }
 
 private:
-    int16_t const m_capacity;
-    int16_t m_poolSize;
-    int16_t m_freeSize;
-    std::unique_ptr<Struct[]> m_pool;
-    std::unique_ptr<int16_t[]> m_free;
+    struct stQueue
+    {
+        std::mutex mutex;
+        std::deque<int32_t> tasks;
+    };
+
+    bool take(int32_t worker, int32_t& task) {
+        for(size_t i = 0; i < m_queues.size(); i++)
+        {
+            stQueue& queue = m_queues[(worker + i) % m_queues.size()];
+
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if(queue.tasks.empty())
+                continue;
+
+            if(!i)
+            {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void drain(int32_t worker) {
+        int32_t task = 0;
+
+        while(take(worker, task))
+        {
+            m_invoke(m_context, task);
+            m_pending.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    void work(int32_t worker) {
+        uint64_t generation = 0;
+
+        while(true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this, generation] { return m_stopping || (m_generation != generation); });
+
+                if(m_stopping)
+                    return;
+
+                generation = m_generation;
+            }
+
+            drain(worker);
+        }
+    }
+
+    std::vector<stQueue> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    void* m_context;
+    void (*m_invoke)(void*, int32_t);
+    std::atomic<int32_t> m_pending;
+    uint64_t m_generation;
+    bool m_stopping;
 };
 
+class stScheduler
+{
+public:
+    using stClock = std::chrono::steady_clock;
+
+    stScheduler(float rate, float budget, int32_t backlog) : m_period(1.0 / rate) , m_budget(budget) , m_backlog(backlog) , m_accumulator(0.0) ,
+                                                             m_ticks(0) , m_dropped(0) , m_overruns(0) , m_worst(0.0) {}
+
+    template<class Function>
+    int32_t advance(float delta, Function&& tick) {
+        m_accumulator += std::max(delta, 0.0f);
+
+        stClock::time_point const start = stClock::now();
+        int32_t ran = 0;
+
+        while(m_accumulator >= m_period)
+        {
+            if(ran && (seconds(start) >= m_budget))
+                break;
+
+            stClock::time_point const begin = stClock::now();
+            tick();
+            double const spent = seconds(begin);
+
+            m_accumulator -= m_period;
+            m_ticks++;
+            ran++;
+
+            m_worst = std::max(m_worst, spent);
+
+            if(spent > m_period)
+                m_overruns++;
+        }
+
+        int64_t const pending = static_cast<int64_t>(m_accumulator / m_period);
+
+        if(pending > m_backlog)
+        {
+            m_dropped += pending - m_backlog;
+            m_accumulator -= (pending - m_backlog) * m_period;
+        }
+
+        return ran;
+    }
+
+    template<class Function>
+    void run(std::atomic<bool> const& running, Function&& tick) {
+        stClock::time_point last = stClock::now();
+
+        while(running.load(std::memory_order_relaxed))
+        {
+            stClock::time_point const now = stClock::now();
+
+            advance(static_cast<float>(std::chrono::duration<double>(now - last).count()), tick);
+            last = now;
+
+            std::this_thread::sleep_until(now + std::chrono::duration_cast<stClock::duration>(std::chrono::duration<double>(m_period - m_accumulator)));
+        }
+    }
+
+    float alpha() const { return static_cast<float>(m_accumulator / m_period); }
+
+    uint64_t ticks() const { return m_ticks; }
+    uint64_t dropped() const { return m_dropped; }
+    uint64_t overruns() const { return m_overruns; }
+    double worst() const { return m_worst; }
+
+private:
+    static double seconds(stClock::time_point const& since) {
+        return std::chrono::duration<double>(stClock::now() - since).count();
+    }
+
+    double const m_period;
+    double const m_budget;
+    int64_t const m_backlog;
+
+    double m_accumulator;
+
+    uint64_t m_ticks;
+    uint64_t m_dropped;
+    uint64_t m_overruns;
+    double m_worst;
+};
 
 #endif // SUBTILE_SUBCORE_H
@@ -8,40 +8,477 @@
 #include <cstring>
 #include <cassert>
 
-stMaterial::stMaterial(stLabel const& label) : label(label)
+stMaterial::stMaterial(stLabel const& label) : label(label) , base(0)
 {
-    for(size_t i = 0; i < Values.size(); i++)
+    for(size_t i = 0; i < Count; i++)
         values[i] = Values[i].limit;
 }
 
+void stMaterial::encode(stPackage& package) const
+{
+    int16_t encoded[Count];
+
+    for(size_t i = 0; i < Count; i++)
+        encoded[i] = values[i].value;
+
+    package.encode(label.str(), encoded, Count);
+}
+
+void stMaterial::decode(stPackage& package)
+{
+    int16_t decoded[stSettings::StoragePackage / sizeof(int16_t)];
+    uint8_t elements = 0;
+
+    label = package.name();
+    package.decode(label.str(), decoded, elements);
+
+    for(size_t i = 0; (i < Count) && (i < elements); i++)
+        values[i] = decoded[i];
+}
+
+int32_t stMaterials::acquire()
+{
+    int32_t handle = 0;
+    m_pool.acquire(handle);
+
+    size_t const slot = stPool<stRecord>::index(handle);
+
+    if(slot >= m_live.size())
+    {
+        size_t const rows = (slot / stSimd::Lanes + 1) * stSimd::Lanes;
+
+        m_live.resize(rows, 0);
+        m_references.resize(rows, 0);
+
+        for(std::vector<int16_t>& column : m_columns)
+            column.resize(rows, 0);
+    }
+
+    m_live[slot] = -1;
+    m_references[slot] = 1;
+
+    return handle;
+}
+
+int32_t stMaterials::instance(stMaterial const& material)
+{
+    assert(material.instanced());
+
+    stInstance found;
+    found.base = material.base;
+
+    for(size_t i = 0; i < m_columns.size(); i++)
+        found.values[i] = material.values[i].value;
+
+    if(int32_t const* const shared = m_instances.find(found))
+    {
+        retain(*shared);
+        return *shared;
+    }
+
+    int32_t const handle = acquire();
+    store(handle, material);
+
+    return m_instances.insert(found, handle);
+}
+
+void stMaterials::retain(int32_t handle)
+{
+    m_pool.at(handle);
+    m_references[stPool<stRecord>::index(handle)]++;
+}
+
+void stMaterials::release(int32_t handle)
+{
+    size_t const slot = stPool<stRecord>::index(handle);
+    bool const instanced = m_pool.at(handle).base;
+
+    if(--m_references[slot] > 0)
+        return;
+
+    if(instanced)
+    {
+        m_pending.push_back(handle);
+        return;
+    }
+
+    m_pool.release(handle);
+    m_live[slot] = 0;
+}
+
+int32_t stMaterials::reclaim(int32_t budget)
+{
+    size_t const count = std::min(m_pending.size() - m_head, static_cast<size_t>(std::max(budget, 0)));
+    size_t const last = m_head + count;
+
+    std::vector<int32_t> handles;
+    handles.reserve(count);
+
+    for(size_t i = m_head; i < last; i++)
+    {
+        int32_t const handle = m_pending[i];
+        size_t const slot = stPool<stRecord>::index(handle);
+
+        if(!m_pool.valid(handle) || m_references[slot] || !m_live[slot])
+            continue;
+
+        m_instances.erase(key(handle));
+        m_live[slot] = 0;
+
+        handles.push_back(handle);
+    }
+
+    m_head = last;
+
+    if(m_head == m_pending.size())
+    {
+        m_pending.clear();
+        m_head = 0;
+    }
+    else if(m_head * 2 > m_pending.size())
+    {
+        m_pending.erase(m_pending.begin(), m_pending.begin() + m_head);
+        m_head = 0;
+    }
+
+    m_pool.release(handles.data(), static_cast<int32_t>(handles.size()));
+
+    return static_cast<int32_t>(handles.size());
+}
+
+stMaterial stMaterials::at(int32_t handle) const
+{
+    stRecord const& record = m_pool.at(handle);
+    size_t const slot = stPool<stRecord>::index(handle);
+
+    stMaterial material(record.label);
+    material.base = record.base;
+
+    for(size_t i = 0; i < m_columns.size(); i++)
+        material.values[i] = m_columns[i][slot];
+
+    return material;
+}
+
+void stMaterials::store(int32_t handle, stMaterial const& material)
+{
+    stRecord& record = m_pool.at(handle);
+    size_t const slot = stPool<stRecord>::index(handle);
+
+    record.label = material.label;
+    record.base = material.base;
+
+    for(size_t i = 0; i < m_columns.size(); i++)
+        m_columns[i][slot] = material.values[i].value;
+}
+
+int32_t stMaterials::select(int32_t value, int16_t lower, int16_t upper, std::vector<int32_t>& handles) const
+{
+    size_t const offset = handles.size();
+    handles.resize(offset + m_live.size());
+
+    int32_t const found = stSimd::select(m_columns[value].data(), m_live.data(), static_cast<int32_t>(m_live.size()), lower, upper, &handles[offset]);
+    handles.resize(offset + found);
+
+    for(size_t i = offset; i < handles.size(); i++)
+        handles[i] = m_pool.handle(handles[i]);
+
+    return found;
+}
+
+int32_t stMaterials::compact(int32_t budget, std::vector<std::pair<int32_t, int32_t>>& moves)
+{
+    int32_t const reclaimed = m_pool.compact(budget, [this, &moves](int32_t from, int32_t to) {
+        int32_t const source = stPool<stRecord>::index(from);
+        int32_t const target = stPool<stRecord>::index(to);
+
+        for(std::vector<int16_t>& column : m_columns)
+            column[target] = column[source];
+
+        m_live[target] = m_live[source];
+        m_live[source] = 0;
+        m_references[target] = m_references[source];
+        m_references[source] = 0;
+
+        moves.emplace_back(from, to);
+    });
+
+    if(moves.empty())
+        return reclaimed;
+
+    std::sort(moves.begin(), moves.end());
+
+    std::vector<int32_t> targets;
+    targets.reserve(moves.size());
+
+    for(std::pair<int32_t, int32_t> const& move : moves)
+        targets.push_back(move.second);
+
+    std::sort(targets.begin(), targets.end());
+
+    m_pool.each([this, &moves, &targets](int32_t handle, stRecord& record) {
+        if(!record.base)
+            return;
+
+        int32_t const base = record.base;
+        remap(moves, record.base);
+
+        if(base != record.base)
+        {
+            stInstance stale = key(handle);
+            stale.base = base;
+
+            m_instances.erase(stale);
+            m_instances.insert(key(handle), handle);
+        }
+        else if(std::binary_search(targets.begin(), targets.end(), handle))
+            m_instances.insert(key(handle), handle);
+    });
+
+    for(size_t i = m_head; i < m_pending.size(); i++)
+        remap(moves, m_pending[i]);
+
+    return reclaimed;
+}
+
+void stMaterials::remap(std::vector<std::pair<int32_t, int32_t>> const& moves, int32_t& handle)
+{
+    auto const found = std::lower_bound(moves.begin(), moves.end(), std::make_pair(std::abs(handle), 0));
+
+    if((found != moves.end()) && (found->first == std::abs(handle)))
+        handle = (handle < 0) ? -found->second : found->second;
+}
+
+uint64_t stMaterials::stInstance::hash() const
+{
+    uint64_t value = stKey(base, 0, 0).hash();
+
+    for(int16_t const element : values)
+        value = (value ^ static_cast<uint16_t>(element)) * 0x100000001B3ull;
+
+    return value ^ (value >> 29);
+}
+
+bool stMaterials::stInstance::operator == (stInstance const& right) const
+{
+    return (base == right.base) && std::equal(std::begin(values), std::end(values), std::begin(right.values));
+}
+
+stMaterials::stInstance stMaterials::key(int32_t handle) const
+{
+    stInstance found;
+    found.base = m_pool.at(handle).base;
+
+    for(size_t i = 0; i < m_columns.size(); i++)
+        found.values[i] = m_columns[i][stPool<stRecord>::index(handle)];
+
+    return found;
+}
+
+stBehaviors::stBehaviors(size_t reserve)
+{
+    m_heaters.components.reserve(reserve);
+    m_heaters.owners.reserve(reserve);
+    m_decays.components.reserve(reserve);
+    m_decays.owners.reserve(reserve);
+}
+
+int32_t stBehaviors::acquire(stBehavior const& behavior, stOwner const& owner)
+{
+    int16_t const limit = stMaterial::Values[stMaterial::Temperature].limit;
+    int32_t index = 0;
+
+    switch(behavior.type)
+    {
+        case stBehavior::Heater:
+            index = static_cast<int32_t>(m_heaters.components.size());
+            m_heaters.components.push_back({ std::clamp<int16_t>(behavior.value, 0, limit), std::clamp<int16_t>(behavior.amount, 0, limit) });
+            m_heaters.owners.push_back(owner);
+            break;
+
+        case stBehavior::Decay:
+            index = static_cast<int32_t>(m_decays.components.size());
+            m_decays.components.push_back({ behavior.value, behavior.amount });
+            m_decays.owners.push_back(owner);
+            break;
+
+        default:
+            return 0;
+    }
+
+    return (index << BitsType) | behavior.type;
+}
+
+bool stBehaviors::release(int32_t handle, stOwner& moved)
+{
+    switch(type(handle))
+    {
+        case stBehavior::Heater: return remove(m_heaters, index(handle), moved);
+        case stBehavior::Decay: return remove(m_decays, index(handle), moved);
+    }
+
+    throw stException("stBehaviors::release");
+}
+
+stBehavior stBehaviors::at(int32_t handle) const
+{
+    switch(type(handle))
+    {
+        case stBehavior::None:
+            return stBehavior();
+
+        case stBehavior::Heater:
+        {
+            stHeater const& heater = m_heaters.components.at(index(handle));
+            return stBehavior(stBehavior::Heater, heater.target, heater.rate);
+        }
+
+        case stBehavior::Decay:
+        {
+            stDecay const& decay = m_decays.components.at(index(handle));
+            return stBehavior(stBehavior::Decay, decay.life, decay.amount);
+        }
+    }
+
+    throw stException("stBehaviors::at");
+}
+
+template<class Component>
+bool stBehaviors::remove(stComponents<Component>& components, int32_t index, stOwner& moved)
+{
+    size_t const last = components.components.size() - 1;
+
+    if(static_cast<size_t>(index) > last)
+        throw stException("stBehaviors::remove");
+
+    bool const swapped = static_cast<size_t>(index) != last;
+
+    if(swapped)
+    {
+        components.components[index] = components.components[last];
+        components.owners[index] = components.owners[last];
+        moved = components.owners[index];
+    }
+
+    components.components.pop_back();
+    components.owners.pop_back();
+
+    return swapped;
+}
+
 struct stSubtile::stTile
 {
     stTile()=default;
-    stTile(int32_t altitude, float x, float y, int16_t m = 0, int16_t b = 0) : location(altitude, x, y) , material(m) , behavior(b) {}
+    stTile(int32_t m, int32_t b) : material(m) , behavior(b) {}
 
-    stLocation location;
-    int16_t material;
-    int16_t behavior;
+    int32_t material;
+    int32_t behavior;
 };
 
 struct stSubtile::stIsland
 {
+    static_assert(stSettings::CellsIsland * stSettings::CellsIsland == 64 && stSettings::StorageIsland == 64, "island cells are addressed by a 64-bit mask");
+
+    enum Sides {
+        West,
+        East,
+        South,
+        North
+    };
+
+    static constexpr int32_t Offsets[4][2] = { { -stSettings::SizeIsland, 0 }, { stSettings::SizeIsland, 0 }, { 0, -stSettings::SizeIsland }, { 0, stSettings::SizeIsland } };
+
     stIsland()=default;
-    stIsland(int32_t x, int32_t y, int32_t z) : xyz{ x, y, z } , life(stSettings::LifetimeIsland) , tiles(0) ,
-                                                bounds(stLocation(z, x, y), stLocation(z, x + stSettings::SizeIsland, y + stSettings::SizeIsland)) {}
+    stIsland(int32_t h, int32_t x, int32_t y, int32_t z) : handle(h) , xyz{ x, y, z } , code(stKey(x / stSettings::SizeIsland, y / stSettings::SizeIsland, z).morton()) ,
+                                                           expiry(0) , occupied(0) , destroyed(0) , temperature{} , buffer(0) ,
+                                                           active(false) , changed(false) , quiet(0) , neighbours{} ,
+                                                           bounds(stLocation(z, x, y), stLocation(z, x + stSettings::SizeIsland, y + stSettings::SizeIsland)) {}
+
+    uint8_t cell(stVector const& position) const {
+        static auto constexpr local = [](float value, int32_t origin) {
+            float const index = std::floor((value - origin) / stSettings::SizeCell);
+            return static_cast<int32_t>(std::clamp(index, 0.0f, static_cast<float>(stSettings::CellsIsland - 1)));
+        };
+
+        return static_cast<uint8_t>(local(position.y, xyz[1]) * stSettings::CellsIsland + local(position.x, xyz[0]));
+    }
+
+    uint64_t cells(stBounds const& bounds) const {
+        static auto constexpr range = [](float lower, float upper, int32_t origin, int32_t& first, int32_t& last) {
+            first = static_cast<int32_t>(std::clamp(std::ceil((lower - origin) / stSettings::SizeCell), 0.0f, static_cast<float>(stSettings::CellsIsland)));
+            last = static_cast<int32_t>(std::clamp(std::floor((upper - origin) / stSettings::SizeCell), -1.0f, static_cast<float>(stSettings::CellsIsland - 1)));
+            return first <= last;
+        };
+
+        int32_t x0, x1, y0, y1;
+
+        if(!range(bounds.lower.position.x, bounds.upper.position.x, xyz[0], x0, x1) || !range(bounds.lower.position.y, bounds.upper.position.y, xyz[1], y0, y1))
+            return 0;
+
+        uint64_t const row = (0xFFull >> (stSettings::CellsIsland - 1 - x1)) & (0xFFull << x0);
+        uint64_t const rows = (~0ull >> ((stSettings::CellsIsland - 1 - y1) * stSettings::CellsIsland)) & (~0ull << (y0 * stSettings::CellsIsland));
+
+        return (row * 0x0101010101010101ull) & rows;
+    }
+
+    stVector position(uint8_t cell) const {
+        return stVector(xyz[0] + (cell % stSettings::CellsIsland) * stSettings::SizeCell, xyz[1] + (cell / stSettings::CellsIsland) * stSettings::SizeCell);
+    }
 
+    int16_t* front() { return temperature[buffer]; }
+    int16_t const* front() const { return temperature[buffer]; }
+    int16_t* back() { return temperature[buffer ^ 1]; }
+
+    void swap() { buffer ^= 1; }
+
+    int32_t handle;
     int32_t xyz[3];
-    int32_t life;
-    uint8_t tiles;
+    uint64_t code;
+    uint64_t expiry;
+    uint64_t occupied;
+    uint64_t destroyed;
     stTile storage[stSettings::StorageIsland];
+    int16_t temperature[2][stSettings::StorageIsland];
+    uint8_t buffer;
+    bool active;
+    bool changed;
+    int32_t quiet;
+    stIsland* neighbours[4];
+    stBounds bounds;
+    stRegion* region;
+};
+
+struct stSubtile::stRegion
+{
+    stRegion()=default;
+    stRegion(int32_t h, int32_t x, int32_t y, int32_t z) : handle(h) , xyz{ x, y, z } , code(stKey(x / stSettings::SizeRegion, y / stSettings::SizeRegion, z).morton()) ,
+                                                           bounds(stLocation(z, x, y), stLocation(z, x + stSettings::SizeRegion, y + stSettings::SizeRegion)) {}
+
+    int32_t handle;
+    int32_t xyz[3];
+    uint64_t code;
+    std::vector<stIsland*> islands;
     stBounds bounds;
 };
 
-stSubtile::stSubtile(std::string const& guid) : m_guid(guid) , m_directory(guid + '/') , m_materialsPool(stSettings::PoolMaterial) ,
-                                                m_behaviorsPool(stSettings::PoolBehavior) , m_islandsPool(stSettings::PoolIsland)
+struct stSubtile::stLayer
 {
-    m_materialsPool.acquire() = stMaterial("blank");
-    m_behaviorsPool.acquire() = stBehavior();
+    stLayer()=default;
+    stLayer(int32_t altitude) : altitude(altitude) {}
+
+    int32_t altitude;
+    std::vector<stRegion*> regions;
+};
+
+stSubtile::stSubtile(std::string const& guid) : m_guid(guid) , m_directory(guid + '/') , m_compacting(false) , m_materialsStore(stSettings::PoolMaterial) ,
+                                                m_behaviorsStore(stSettings::PoolBehavior) , m_islandsPool(stSettings::PoolIsland) ,
+                                                m_regionsPool(stSettings::PoolRegion)
+{
+    threads(stSettings::ThreadsStep ? stSettings::ThreadsStep : static_cast<int32_t>(std::thread::hardware_concurrency()));
+
+    m_materialsStore.store(m_materialsStore.acquire(), stMaterial("blank"));
+    m_islandsPool.acquire() = stIsland();
+    m_regionsPool.acquire() = stRegion();
 }
 
 stSubtile::~stSubtile()
@@ -56,66 +493,220 @@ void stSubtile::parse(stPackage const& package)
 
 void stSubtile::parse(stRequest const& request)
 {
-    int16_t materialHandle = 0;
-    int16_t behaviorHandle = 0;
-
-    for(size_t i = 0; i < m_materials.size(); i++)
-    {
-        if(!m_materials[i]->instanced() && (m_materials[i]->label == request.material.label))
-        {
-            materialHandle = static_cast<int16_t>(i);
-            i = m_materials.size();
-        }
-    }
+    int32_t materialHandle = 0;
 
-    if(materialHandle == 0)
-        material(materialHandle, true) = request.material;
+    if(int32_t const* const found = m_materialsTable.find(request.material.label))
+        materialHandle = *found;
+    else
+        material(materialHandle, request.material);
 
     stIsland* const islandPointer = island(request.location.altitude, request.location.position.x, request.location.position.y);
-    islandPointer->storage[islandPointer->tiles++] = stTile(request.location.altitude, request.location.position.x, request.location.position.y, materialHandle, behaviorHandle);
+
+    place(islandPointer, materialHandle, request);
+    activate(islandPointer);
 }
 
-void stSubtile::visit(stVisitor& visitor)
+void stSubtile::parse(stRequest const* requests, size_t count)
 {
-    for(stMaterial* material : m_materials)
-        visitor.onMaterial(*material);
+    std::vector<stIsland*> islands;
+    std::vector<size_t> ends;
+    std::vector<stKey> missing;
+    std::vector<std::pair<size_t, int32_t>> unresolved;
+    std::vector<int32_t> handles;
+
+    stLabel const* label = nullptr;
+    int32_t materialHandle = 0;
 
-    for(stIsland* island : m_islands)
+    for(size_t first = 0; first < count; first += stSettings::BatchParse)
     {
-        stLocation location;
-        location.altitude = island->xyz[2];
+        size_t const last = std::min(count, first + stSettings::BatchParse);
 
-        for(uint8_t i = 0; i < island->tiles; i++)
+        stTable<stKey, int32_t> seen;
+        stKey previous;
+
+        islands.clear();
+        ends.clear();
+        missing.clear();
+        unresolved.clear();
+
+        for(size_t i = first; i < last; i++)
         {
-            location.position = island->storage[i].location.position;
-            visitor.onTile(location, *material(island->storage[i].material), *behavior(island->storage[i].behavior));
+            stKey const key = locate(requests[i].location);
+
+            if((i > first) && (key == previous))
+            {
+                ends.back() = i + 1;
+                continue;
+            }
+
+            previous = key;
+            ends.push_back(i + 1);
+
+            if(stIsland** const found = m_islandsTable.find(key))
+            {
+                islands.push_back(*found);
+                continue;
+            }
+
+            if(int32_t const* const found = seen.find(key))
+                unresolved.emplace_back(islands.size(), *found);
+            else
+            {
+                unresolved.emplace_back(islands.size(), static_cast<int32_t>(missing.size()));
+                seen.insert(key, static_cast<int32_t>(missing.size()));
+                missing.push_back(key);
+            }
+
+            islands.push_back(nullptr);
+        }
+
+        handles.resize(missing.size());
+        m_islandsPool.acquire(static_cast<int32_t>(handles.size()), handles.data());
+
+        for(size_t i = 0; i < missing.size(); i++)
+            attach(handles[i], missing[i]);
+
+        for(std::pair<size_t, int32_t> const& run : unresolved)
+            islands[run.first] = &m_islandsPool.at(handles[run.second]);
+
+        for(size_t run = 0, i = first; run < islands.size(); run++)
+        {
+            activate(islands[run]);
+
+            for(; i < ends[run]; i++)
+            {
+                stRequest const& request = requests[i];
+
+                if(!label || (*label != request.material.label))
+                {
+                    if(int32_t const* const found = m_materialsTable.find(request.material.label))
+                        materialHandle = *found;
+                    else
+                        material(materialHandle, request.material);
+
+                    label = &request.material.label;
+                }
+
+                place(islands[run], materialHandle, request);
+            }
         }
     }
 }
 
-void stSubtile::visit(stVisitor& visitor, stBounds const& bounds)
+void stSubtile::erase(stLocation const& location)
 {
-    for(stIsland* island : m_islands)
+    if(stIsland** const found = m_islandsTable.find(locate(location)))
     {
-        if(bounds.overlaps(island->bounds))
-        {
-            stLocation location;
-            location.altitude = island->xyz[2];
+        uint8_t const cell = (*found)->cell(location.position);
+
+        if((*found)->occupied & (1ull << cell))
+            release((*found)->storage[cell]);
+
+        (*found)->occupied &= ~(1ull << cell);
+        (*found)->destroyed &= ~(1ull << cell);
+
+        if(!(*found)->occupied)
+            expire(*found);
+
+        activate(*found);
+    }
+}
+
+void stSubtile::visit(stVisitor& visitor)
+{
+    for(int32_t handle : m_materials)
+        visitor.onMaterial(material(handle));
 
-            for(uint8_t i = 0; i < island->tiles; i++)
+    for(stLayer const& layer : m_layers)
+    {
+        for(stRegion* region : layer.regions)
+        {
+            for(stIsland* island : region->islands)
             {
-                if(bounds.overlaps(island->storage[i].location))
+                stLocation location;
+                location.altitude = island->xyz[2];
+
+                for(uint64_t cells = island->occupied; cells; cells &= cells - 1)
                 {
-                    location.position = island->storage[i].location.position;
-                    visitor.onTile(location, *material(island->storage[i].material), *behavior(island->storage[i].behavior));
+                    uint8_t const cell = __builtin_ctzll(cells);
+                    stTile const& tile = island->storage[cell];
+
+                    location.position = island->position(cell);
+                    visitor.onTile(location, material(tile.material), behavior(tile.behavior));
+                    visitor.onTemperature(location, island->front()[cell]);
                 }
             }
         }
     }
 }
 
+void stSubtile::visit(stVisitor& visitor, stBounds const& bounds)
+{
+    each(bounds, [this, &visitor](stIsland* island, uint64_t cells) {
+        stLocation location;
+        location.altitude = island->xyz[2];
+
+        for(; cells; cells &= cells - 1)
+        {
+            uint8_t const cell = __builtin_ctzll(cells);
+            stTile const& tile = island->storage[cell];
+
+            location.position = island->position(cell);
+            visitor.onTile(location, material(tile.material), behavior(tile.behavior));
+            visitor.onTemperature(location, island->front()[cell]);
+        }
+    });
+}
+
 stPackage const* stSubtile::step()
 {
+    m_islandsWheel.advance([this](int32_t handle) {
+        if(!m_islandsPool.valid(handle))
+            return;
+
+        stIsland& island = m_islandsPool.at(handle);
+
+        if(!island.occupied && island.expiry && (island.expiry <= m_islandsWheel.tick()))
+            release(&island);
+    });
+
+    for(int32_t handle : m_destroyed)
+    {
+        if(!m_islandsPool.valid(handle))
+            continue;
+
+        stIsland& island = m_islandsPool.at(handle);
+
+        for(uint64_t cells = island.destroyed & island.occupied; cells; cells &= cells - 1)
+            release(island.storage[__builtin_ctzll(cells)]);
+
+        island.occupied &= ~island.destroyed;
+
+        if(!island.occupied)
+            expire(&island);
+
+        activate(&island);
+        island.destroyed = 0;
+    }
+
+    m_destroyed.clear();
+
+    behave();
+    diffuse();
+
+    m_materialsStore.reclaim(stSettings::BudgetReclaim);
+
+    int32_t const holes = m_materialsStore.holes();
+    int32_t const extent = m_materialsStore.size() + holes;
+
+    if((holes >= stSettings::HolesCompact) && (holes * 4 > extent))
+        m_compacting = true;
+    else if((holes < stSettings::HolesCompact / 2) || (holes * 8 <= extent))
+        m_compacting = false;
+
+    if(m_compacting)
+        compact(stSettings::BudgetCompact);
+
     return nullptr;
 }
 
@@ -124,86 +715,575 @@ stPackage const* stSubtile::pack()
     return nullptr;
 }
 
-stMaterial* stSubtile::material(int16_t handle)
+int32_t stSubtile::apply(stBounds const& bounds, int32_t value, int32_t operation, int16_t amount)
 {
-    return &m_materialsPool.at(std::abs(handle));
-}
+    if((value < 0) || (value >= stMaterial::Count) || (operation < 0) || (operation >= stValue::Count))
+        throw stException("stSubtile::apply");
 
-stMaterial& stSubtile::material(int16_t& handle, bool dynamic)
-{
-    if(dynamic)
-    {
-        if(handle == 0)
-        {
-            std::cout << "Creating new material.\n";
+    std::vector<int32_t> sources;
+    std::vector<int32_t> indices;
 
-            m_materialsPool.acquire(handle);
-            m_materialsPool.at(handle) = stMaterial("new");
+    auto source = [&sources, &indices](int32_t handle) {
+        size_t const slot = stMaterials::slot(handle);
 
-            m_materials.push_back(&m_materialsPool.at(handle));
+        if(slot >= indices.size())
+            indices.resize(slot + 1, -1);
+
+        if(indices[slot] < 0)
+        {
+            indices[slot] = static_cast<int32_t>(sources.size());
+            sources.push_back(handle);
         }
-        else if(handle > 0)
+
+        return indices[slot];
+    };
+
+    each(bounds, [&source](stIsland* island, uint64_t cells) {
+        for(int32_t last = 0; cells; cells &= cells - 1)
         {
-            std::cout << "Creating material instance.\n";
+            int32_t const handle = island->storage[__builtin_ctzll(cells)].material;
+
+            if(handle != last)
+                source(last = handle);
+        }
+    });
+
+    if(sources.empty())
+        return 0;
+
+    int32_t const count = static_cast<int32_t>(sources.size());
+
+    std::vector<int16_t> column(count);
+    std::vector<int16_t> hitpoints(count);
+    std::vector<int16_t> live(count, -1);
+
+    for(int32_t i = 0; i < count; i++)
+        column[i] = material(sources[i]).values[value].value;
 
-            int16_t newHandle = 0;
+    stSimd::update(column.data(), live.data(), count, operation, amount, 0, stMaterial::Values[value].limit);
 
-            m_materialsPool.acquire(newHandle);
-            m_materialsPool.at(newHandle) = m_materialsPool.at(handle);
-            m_materialsPool.at(newHandle).values[stMaterial::Base] = handle;
+    std::vector<int32_t> results(count);
 
-            handle = -newHandle;
+    for(int32_t i = 0; i < count; i++)
+    {
+        stMaterial result = material(sources[i]);
+        result.base = (sources[i] < 0) ? result.base : sources[i];
+        result.values[value] = column[i];
+
+        hitpoints[i] = result.hitpoints().value;
+
+        stMaterial const base = m_materialsStore.at(result.base);
+
+        if(std::equal(std::begin(base.values), std::end(base.values), std::begin(result.values), [](stValue const& left, stValue const& right) { return left.value == right.value; }))
+        {
+            results[i] = result.base;
+            m_materialsStore.retain(result.base);
         }
         else
+            results[i] = -m_materialsStore.instance(result);
+    }
+
+    std::vector<int32_t> rows(count);
+    std::vector<bool> destroyed(count, false);
+
+    for(int32_t i = 0, found = stSimd::select(hitpoints.data(), live.data(), count, INT16_MIN, 0, rows.data()); i < found; i++)
+        destroyed[rows[i]] = true;
+
+    int32_t applied = 0;
+
+    each(bounds, [&](stIsland* island, uint64_t cells) {
+        int32_t last = 0;
+        int32_t index = 0;
+
+        activate(island);
+
+        for(; cells; cells &= cells - 1, applied++)
+        {
+            uint8_t const cell = __builtin_ctzll(cells);
+
+            stTile& tile = island->storage[cell];
+
+            if(tile.material != last)
+                index = source(last = tile.material);
+
+            m_materialsStore.retain(std::abs(results[index]));
+            m_materialsStore.release(std::abs(tile.material));
+            tile.material = results[index];
+
+            if(value == stMaterial::Temperature)
+                island->front()[cell] = stSimd::apply(island->front()[cell], operation, amount, 0, stMaterial::Values[value].limit);
+
+            if(destroyed[index])
+            {
+                if(!island->destroyed)
+                    m_destroyed.push_back(island->handle);
+
+                island->destroyed |= 1ull << cell;
+            }
+        }
+    });
+
+    for(int32_t result : results)
+        m_materialsStore.release(std::abs(result));
+
+    return applied;
+}
+
+int32_t stSubtile::diffuse()
+{
+    int32_t constexpr Grid = stSimd::Halo * stSimd::Halo;
+
+    std::vector<stIsland*> islands;
+    size_t kept = 0;
+
+    for(int32_t handle : m_active)
+    {
+        if(!m_islandsPool.valid(handle) || !m_islandsPool.at(handle).active)
+            continue;
+
+        stIsland* const island = &m_islandsPool.at(handle);
+
+        if(!island->occupied)
         {
-            std::cout << "Removing material instance.\n";
+            island->active = false;
+            continue;
+        }
+
+        m_active[kept++] = handle;
+        islands.push_back(island);
+    }
+
+    m_active.resize(kept);
+
+    std::sort(islands.begin(), islands.end(), [](stIsland const* left, stIsland const* right) {
+        if(left->xyz[2] != right->xyz[2])
+            return left->xyz[2] < right->xyz[2];
+
+        if(left->region != right->region)
+            return left->region->code < right->region->code;
 
-            int16_t const newHandle = m_materialsPool.at(std::abs(handle)).values[stMaterial::Base].value;
+        return left->code < right->code;
+    });
 
-            m_materialsPool.release(std::abs(handle));
+    std::vector<size_t> shards;
+
+    for(size_t i = 0; i < islands.size(); i++)
+    {
+        if(!i || (islands[i]->region != islands[i - 1]->region))
+            shards.push_back(i);
+    }
+
+    shards.push_back(islands.size());
+
+    int32_t const regions = static_cast<int32_t>(shards.size() - 1);
+
+    m_workers->run(regions, [&islands, &shards](int32_t region) {
+        int16_t grid[Grid];
+        int16_t live[Grid];
+
+        for(size_t i = shards[region]; i < shards[region + 1]; i++)
+        {
+            halo(islands[i], grid, live);
+            stSimd::diffuse(grid, live, islands[i]->back(), stSettings::ShiftDiffusion);
 
-            handle = newHandle;
+            islands[i]->changed = std::memcmp(islands[i]->back(), islands[i]->front(), sizeof(int16_t) * stSettings::StorageIsland) != 0;
         }
+    });
+
+    for(stIsland* island : islands)
+    {
+        island->swap();
+        island->quiet = island->changed ? 0 : island->quiet + 1;
+    }
+
+    for(stIsland* island : islands)
+    {
+        if(island->changed)
+            activate(island);
+    }
+
+    for(stIsland* island : islands)
+    {
+        if(island->quiet >= stSettings::QuietIsland)
+            island->active = false;
     }
 
-    return m_materialsPool.at(std::abs(handle));
+    kept = 0;
+
+    for(int32_t handle : m_active)
+    {
+        if(m_islandsPool.valid(handle) && m_islandsPool.at(handle).active)
+            m_active[kept++] = handle;
+    }
+
+    m_active.resize(kept);
+
+    return static_cast<int32_t>(islands.size());
 }
 
-stBehavior* stSubtile::behavior(int16_t handle)
+void stSubtile::activate(stIsland* island)
 {
-    return &m_behaviorsPool.at(std::abs(handle));
+    wake(island);
+
+    for(stIsland* neighbour : island->neighbours)
+    {
+        if(neighbour)
+            wake(neighbour);
+    }
 }
 
-stBehavior& stSubtile::behavior(int16_t& handle, bool dynamic)
+void stSubtile::expire(stIsland* island)
 {
-    return m_behaviorsPool.at(std::abs(handle));
+    if(island->expiry)
+        return;
+
+    island->expiry = m_islandsWheel.tick() + stSettings::LifetimeIsland;
+    m_islandsWheel.schedule(island->expiry, island->handle);
 }
 
-stSubtile::stIsland* stSubtile::island(int32_t altitude, int32_t x, int32_t y)
+void stSubtile::wake(stIsland* island)
+{
+    island->quiet = 0;
+
+    if(island->active)
+        return;
+
+    island->active = true;
+    m_active.push_back(island->handle);
+}
+
+void stSubtile::halo(stIsland const* island, int16_t* grid, int16_t* live)
 {
-    static auto constexpr division = [](int32_t& value, int32_t const unit) {
-        value = ((value < 0) ? (value / unit - 1) : (value / unit)) * unit;
+    int32_t constexpr Cells = stSettings::CellsIsland;
+    int32_t constexpr Halo = stSimd::Halo;
+
+    auto copy = [grid, live](stIsland const* source, int32_t cell, int32_t target) {
+        grid[target] = source ? source->front()[cell] : 0;
+        live[target] = (source && (source->occupied >> cell & 1)) ? -1 : 0;
     };
 
-    division(x, stSettings::SizeIsland);
-    division(y, stSettings::SizeIsland);
+    for(int32_t row = 0; row < Cells; row++)
+    {
+        uint32_t const bits = static_cast<uint32_t>(island->occupied >> (row * Cells)) & 0xFF;
+
+        std::memcpy(&grid[(row + 1) * Halo + 1], &island->front()[row * Cells], sizeof(int16_t) * Cells);
+
+        for(int32_t column = 0; column < Cells; column++)
+            live[(row + 1) * Halo + column + 1] = -static_cast<int16_t>((bits >> column) & 1);
+    }
+
+    for(int32_t i = 0; i < Cells; i++)
+    {
+        copy(island->neighbours[stIsland::West], i * Cells + Cells - 1, (i + 1) * Halo);
+        copy(island->neighbours[stIsland::East], i * Cells, (i + 1) * Halo + Halo - 1);
+        copy(island->neighbours[stIsland::South], (Cells - 1) * Cells + i, i + 1);
+        copy(island->neighbours[stIsland::North], i, (Halo - 1) * Halo + i + 1);
+    }
+}
+
+void stSubtile::threads(int32_t count)
+{
+    m_workers.reset(new stWorkers(count));
+}
+
+int32_t stSubtile::compact(int32_t budget)
+{
+    std::vector<std::pair<int32_t, int32_t>> moves;
+
+    int32_t const reclaimed = m_materialsStore.compact(budget, moves);
+
+    if(moves.empty())
+        return reclaimed;
+
+    for(int32_t& handle : m_materials)
+    {
+        stMaterials::remap(moves, handle);
+        m_materialsTable.insert(m_materialsStore.label(handle), handle);
+    }
+
+    for(stLayer const& layer : m_layers)
+    {
+        for(stRegion* region : layer.regions)
+        {
+            for(stIsland* island : region->islands)
+            {
+                for(uint64_t cells = island->occupied; cells; cells &= cells - 1)
+                    stMaterials::remap(moves, island->storage[__builtin_ctzll(cells)].material);
+            }
+        }
+    }
+
+    return reclaimed;
+}
+
+stMaterial stSubtile::material(int32_t handle) const
+{
+    return m_materialsStore.at(std::abs(handle));
+}
+
+void stSubtile::material(int32_t& handle, stMaterial const& definition)
+{
+    handle = m_materialsStore.acquire();
+    stMaterial base = definition;
+    base.base = 0;
+
+    m_materialsStore.store(handle, base);
 
-    for(stIsland* island : m_islands)
+    m_materials.push_back(handle);
+    m_materialsTable.insert(definition.label, handle);
+}
+
+stBehavior stSubtile::behavior(int32_t handle) const
+{
+    return m_behaviorsStore.at(handle);
+}
+
+int32_t stSubtile::behave()
+{
+    stBehaviors::stComponents<stBehaviors::stHeater>& heaters = m_behaviorsStore.heaters();
+
+    stIsland* island = nullptr;
+
+    for(size_t i = 0; i < heaters.components.size(); i++)
     {
-        if((island->xyz[0] == x) && (island->xyz[1] == y) && (island->xyz[2] == altitude))
+        stBehaviors::stHeater const& heater = heaters.components[i];
+        stBehaviors::stOwner const& owner = heaters.owners[i];
+
+        if(!island || (island->handle != owner.island))
+            island = &m_islandsPool.at(owner.island);
+
+        int16_t& temperature = island->front()[owner.cell];
+        int16_t const heated = (temperature < heater.target) ? std::min<int16_t>(temperature + heater.rate, heater.target) : std::max<int16_t>(temperature - heater.rate, heater.target);
+
+        if(heated != temperature)
         {
-            island->life = stSettings::LifetimeIsland;
-            return island;
+            temperature = heated;
+            activate(island);
         }
     }
 
-    m_islands.emplace_back(&m_islandsPool.acquire());
-   *m_islands.back() = stIsland(x, y, altitude);
+    stBehaviors::stComponents<stBehaviors::stDecay>& decays = m_behaviorsStore.decays();
 
-    return m_islands.back();
+    for(size_t i = 0; i < decays.components.size(); i++)
+    {
+        stBehaviors::stDecay& decay = decays.components[i];
+
+        if(decay.life <= 0)
+            continue;
+
+        decay.life = std::max<int16_t>(decay.life - decay.amount, 0);
+
+        if(decay.life > 0)
+            continue;
+
+        stIsland& island = m_islandsPool.at(decays.owners[i].island);
+
+        if(!island.destroyed)
+            m_destroyed.push_back(island.handle);
+
+        island.destroyed |= 1ull << decays.owners[i].cell;
+    }
+
+    return static_cast<int32_t>(m_behaviorsStore.size());
+}
+
+stSubtile::stIsland* stSubtile::island(int32_t altitude, int32_t x, int32_t y)
+{
+    x = snap(x, stSettings::SizeIsland);
+    y = snap(y, stSettings::SizeIsland);
+
+    stKey const key(x, y, altitude);
+
+    if(stIsland** const found = m_islandsTable.find(key))
+        return *found;
+
+    int32_t handle = 0;
+    m_islandsPool.acquire(handle);
+
+    return attach(handle, key);
 }
 
 stSubtile::stIsland* stSubtile::island(int32_t altitude, float x, float y)
 {
-    return island(altitude, static_cast<int32_t>(x), static_cast<int32_t>(y));
+    return island(altitude, static_cast<int32_t>(std::floor(x)), static_cast<int32_t>(std::floor(y)));
+}
+
+stSubtile::stIsland* stSubtile::attach(int32_t handle, stKey const& key)
+{
+    stRegion* const regionPointer = region(key.xyz[2], key.xyz[0], key.xyz[1]);
+
+    stIsland* const islandPointer = &m_islandsPool.at(handle);
+   *islandPointer = stIsland(handle, key.xyz[0], key.xyz[1], key.xyz[2]);
+    islandPointer->region = regionPointer;
+
+    expire(islandPointer);
+    insert(regionPointer->islands, islandPointer);
+
+    for(int32_t side = 0; side < 4; side++)
+    {
+        if(stIsland** const found = m_islandsTable.find(stKey(key.xyz[0] + stIsland::Offsets[side][0], key.xyz[1] + stIsland::Offsets[side][1], key.xyz[2])))
+        {
+            islandPointer->neighbours[side] = *found;
+            (*found)->neighbours[side ^ 1] = islandPointer;
+        }
+    }
+
+    return m_islandsTable.insert(key, islandPointer);
+}
+
+void stSubtile::place(stIsland* island, int32_t material, stRequest const& request)
+{
+    m_materialsStore.retain(material);
+
+    uint8_t const cell = island->cell(request.location.position);
+
+    if(island->occupied & (1ull << cell))
+        release(island->storage[cell]);
+
+    island->storage[cell] = stTile(material, m_behaviorsStore.acquire(request.behavior, { island->handle, cell }));
+    island->front()[cell] = m_materialsStore.value(material, stMaterial::Temperature);
+    island->occupied |= 1ull << cell;
+    island->destroyed &= ~(1ull << cell);
+    island->expiry = 0;
+}
+
+stSubtile::stRegion* stSubtile::region(int32_t altitude, int32_t x, int32_t y)
+{
+    x = snap(x, stSettings::SizeRegion);
+    y = snap(y, stSettings::SizeRegion);
+
+    stKey const key(x, y, altitude);
+
+    if(stRegion** const found = m_regionsTable.find(key))
+        return *found;
+
+    int32_t handle = 0;
+
+    stRegion* const regionPointer = &m_regionsPool.acquire(handle);
+   *regionPointer = stRegion(handle, x, y, altitude);
+
+    insert(layer(altitude).regions, regionPointer);
+
+    return m_regionsTable.insert(key, regionPointer);
+}
+
+stSubtile::stLayer& stSubtile::layer(int32_t altitude)
+{
+    auto const found = std::lower_bound(m_layers.begin(), m_layers.end(), altitude, [](stLayer const& left, int32_t altitude) {
+        return left.altitude < altitude;
+    });
+
+    if((found != m_layers.end()) && (found->altitude == altitude))
+        return *found;
+
+    return *m_layers.insert(found, stLayer(altitude));
+}
+
+template<class Function>
+void stSubtile::each(stBounds const& bounds, Function&& function)
+{
+    auto layer = std::lower_bound(m_layers.begin(), m_layers.end(), bounds.lower.altitude, [](stLayer const& left, int32_t altitude) {
+        return left.altitude < altitude;
+    });
+
+    for(; (layer != m_layers.end()) && (layer->altitude <= bounds.upper.altitude); layer++)
+    {
+        for(stRegion* region : layer->regions)
+        {
+            if(!bounds.overlaps(region->bounds))
+                continue;
+
+            for(stIsland* island : region->islands)
+            {
+                if(!bounds.overlaps(island->bounds))
+                    continue;
+
+                if(uint64_t const cells = island->occupied & island->cells(bounds))
+                    function(island, cells);
+            }
+        }
+    }
+}
+
+void stSubtile::release(stTile const& tile)
+{
+    m_materialsStore.release(std::abs(tile.material));
+
+    stBehaviors::stOwner moved;
+
+    if(tile.behavior && m_behaviorsStore.release(tile.behavior, moved))
+        m_islandsPool.at(moved.island).storage[moved.cell].behavior = tile.behavior;
+}
+
+void stSubtile::release(stIsland* island)
+{
+    for(uint64_t cells = island->occupied; cells; cells &= cells - 1)
+        release(island->storage[__builtin_ctzll(cells)]);
+
+    m_islandsTable.erase(stKey(island->xyz[0], island->xyz[1], island->xyz[2]));
+
+    for(int32_t side = 0; side < 4; side++)
+    {
+        if(island->neighbours[side])
+        {
+            island->neighbours[side]->neighbours[side ^ 1] = nullptr;
+            wake(island->neighbours[side]);
+        }
+    }
+
+    erase(island->region->islands, island);
+
+    if(island->region->islands.empty())
+        release(island->region);
+
+    m_islandsPool.release(island->handle);
+}
+
+void stSubtile::release(stRegion* region)
+{
+    m_regionsTable.erase(stKey(region->xyz[0], region->xyz[1], region->xyz[2]));
+
+    stLayer& layerReference = layer(region->xyz[2]);
+    erase(layerReference.regions, region);
+
+    if(layerReference.regions.empty())
+        m_layers.erase(m_layers.begin() + (&layerReference - m_layers.data()));
+
+    m_regionsPool.release(region->handle);
+}
+
+template<class Struct>
+void stSubtile::insert(std::vector<Struct*>& ordered, Struct* element)
+{
+    auto const position = std::upper_bound(ordered.begin(), ordered.end(), element->code, [](uint64_t code, Struct const* right) {
+        return code < right->code;
+    });
+
+    ordered.insert(position, element);
+}
+
+template<class Struct>
+void stSubtile::erase(std::vector<Struct*>& ordered, Struct* element)
+{
+    auto position = std::lower_bound(ordered.begin(), ordered.end(), element->code, [](Struct const* left, uint64_t code) {
+        return left->code < code;
+    });
+
+    while(*position != element)
+        position++;
+
+    ordered.erase(position);
+}
+
+stKey stSubtile::locate(stLocation const& location)
+{
+    int32_t const x = snap(static_cast<int32_t>(std::floor(location.position.x)), stSettings::SizeIsland);
+    int32_t const y = snap(static_cast<int32_t>(std::floor(location.position.y)), stSettings::SizeIsland);
+
+    return stKey(x, y, location.altitude);
+}
+
+int32_t stSubtile::snap(int32_t value, int32_t unit)
+{
+    return ((value < 0) ? ((value + 1) / unit - 1) : (value / unit)) * unit;
 }
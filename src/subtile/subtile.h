@@ -3,42 +3,180 @@
 
 #include "subcore.h"
 
+#define SUBTILE_MATERIAL_VALUES(Field) \
+    Field(Volume, volume, 100) \
+    Field(Density, density, 100) \
+    Field(Hitpoints, hitpoints, 100) \
+    Field(Temperature, temperature, 100) \
+    Field(Transparency, transparency, 100)
+
 class stMaterial
 {
 public:
+#define SUBTILE_MATERIAL_ENUM(Name, name, limit) Name,
+#define SUBTILE_MATERIAL_META(Name, name, limit) stValueMeta(#name, Name, limit),
+#define SUBTILE_MATERIAL_ACCESSOR(Name, name, limit) \
+    stValue& name() { return values[Name]; } \
+    stValue const& name() const { return values[Name]; }
+
     enum Values {
-        Base,
-        Volume,
-        Density,
-        Hitpoints,
-        Temperature,
-        Transparency
+        SUBTILE_MATERIAL_VALUES(SUBTILE_MATERIAL_ENUM)
+        Count
     };
 
-    static constexpr std::array<stValueMeta, 6> Values =
+    static constexpr std::array<stValueMeta, Count> Values =
     {
-        stValueMeta("base", Base, 0),
-        stValueMeta("volume", Volume, 100),
-        stValueMeta("density", Density, 100),
-        stValueMeta("hitpoints", Hitpoints, 100),
-        stValueMeta("temperature", Temperature, 100),
-        stValueMeta("transparency", Transparency, 100)
+        SUBTILE_MATERIAL_VALUES(SUBTILE_MATERIAL_META)
     };
 
     stMaterial()=default;
     stMaterial(stLabel const& label);
 
-    bool instanced() const { return values[Base].value != Values[Base].limit; }
-    bool destroyed() const { return values[Hitpoints].value <= 0; }
+    SUBTILE_MATERIAL_VALUES(SUBTILE_MATERIAL_ACCESSOR)
+
+#undef SUBTILE_MATERIAL_ENUM
+#undef SUBTILE_MATERIAL_META
+#undef SUBTILE_MATERIAL_ACCESSOR
+
+    bool instanced() const { return base != 0; }
+    bool destroyed() const { return hitpoints().value <= 0; }
+
+    void encode(stPackage& package) const;
+    void decode(stPackage& package);
 
     stLabel label;
-    stValue values[6];
+    int32_t base;
+    stValue values[Count];
+};
+
+static_assert(stValueMeta::ordered(stMaterial::Values), "stMaterial::Values");
+
+class stMaterials
+{
+public:
+    stMaterials(int32_t chunk) : m_pool(chunk) , m_head(0) {}
+
+    int32_t acquire();
+    int32_t instance(stMaterial const& material);
+    void retain(int32_t handle);
+    void release(int32_t handle);
+    int32_t reclaim(int32_t budget);
+
+    stMaterial at(int32_t handle) const;
+    void store(int32_t handle, stMaterial const& material);
+
+    stLabel const& label(int32_t handle) const { return m_pool.at(handle).label; }
+    int32_t base(int32_t handle) const { return m_pool.at(handle).base; }
+    int16_t value(int32_t handle, int32_t value) const { return m_columns[value][stPool<stRecord>::index(handle)]; }
+    static int32_t slot(int32_t handle) { return stPool<stRecord>::index(std::abs(handle)); }
+
+    int32_t select(int32_t value, int16_t lower, int16_t upper, std::vector<int32_t>& handles) const;
+
+    int32_t compact(int32_t budget, std::vector<std::pair<int32_t, int32_t>>& moves);
+    static void remap(std::vector<std::pair<int32_t, int32_t>> const& moves, int32_t& handle);
+
+    int32_t size() const { return m_pool.size(); }
+    int32_t holes() const { return m_pool.holes(); }
+
+private:
+    struct stRecord
+    {
+        stLabel label;
+        int32_t base;
+    };
+
+    struct stInstance
+    {
+        uint64_t hash() const;
+
+        bool operator == (stInstance const& right) const;
+        bool operator != (stInstance const& right) const { return !(*this == right); }
+
+        int32_t base;
+        int16_t values[stMaterial::Count];
+    };
+
+    stInstance key(int32_t handle) const;
+
+    stPool<stRecord> m_pool;
+    stTable<stInstance, int32_t> m_instances;
+    std::vector<int32_t> m_pending;
+    size_t m_head;
+    std::vector<int16_t> m_live;
+    std::vector<int32_t> m_references;
+    std::array<std::vector<int16_t>, stMaterial::Count> m_columns;
 };
 
 class stBehavior
 {
 public:
+    enum Types {
+        None,
+        Heater,
+        Decay,
+        Count
+    };
+
+    stBehavior() : type(None) , value(0) , amount(0) {}
+    stBehavior(int32_t type, int16_t value, int16_t amount) : type(type) , value(value) , amount(amount) {}
+
+    int32_t type;
+    int16_t value;
+    int16_t amount;
+};
+
+class stBehaviors
+{
+public:
+    static constexpr int32_t BitsType = 4;
+    static constexpr int32_t MaskType = (1 << BitsType) - 1;
+
+    static int32_t type(int32_t handle) { return handle & MaskType; }
+    static int32_t index(int32_t handle) { return handle >> BitsType; }
+
+    struct stOwner
+    {
+        int32_t island;
+        int32_t cell;
+    };
+
+    struct stHeater
+    {
+        int16_t target;
+        int16_t rate;
+    };
+
+    struct stDecay
+    {
+        int16_t life;
+        int16_t amount;
+    };
+
+    template<class Component>
+    struct stComponents
+    {
+        std::vector<Component> components;
+        std::vector<stOwner> owners;
+    };
 
+    stBehaviors(size_t reserve);
+
+    int32_t acquire(stBehavior const& behavior, stOwner const& owner);
+    bool release(int32_t handle, stOwner& moved);
+
+    stBehavior at(int32_t handle) const;
+
+    stComponents<stHeater>& heaters() { return m_heaters; }
+    stComponents<stDecay>& decays() { return m_decays; }
+
+    size_t size() const { return m_heaters.components.size() + m_decays.components.size(); }
+
+private:
+    template<class Component>
+    static bool remove(stComponents<Component>& components, int32_t index, stOwner& moved);
+
+    stComponents<stHeater> m_heaters;
+    stComponents<stDecay> m_decays;
 };
 
 class stRequest
@@ -59,6 +197,7 @@ public:
     virtual void onMaterial(stMaterial const& material) {}
     virtual void onBehavior(stBehavior const& behavior) {}
     virtual void onTile(stLocation const& transform, stMaterial const& material, stBehavior const& behavior) {}
+    virtual void onTemperature(stLocation const& transform, int16_t temperature) {}
 };
 
 class stSubtile
@@ -69,6 +208,8 @@ public:
 
     void parse(stPackage const& package);
     void parse(stRequest const& request);
+    void parse(stRequest const* requests, size_t count);
+    void erase(stLocation const& location);
 
     void visit(stVisitor& visitor);
     void visit(stVisitor& visitor, stBounds const& bounds);
@@ -76,28 +217,68 @@ public:
     stPackage const* step();
     stPackage const* pack();
 
+    int32_t apply(stBounds const& bounds, int32_t value, int32_t operation, int16_t amount);
+    int32_t compact(int32_t budget);
+    void threads(int32_t count);
+    size_t active() const { return m_active.size(); }
+
 private:
     struct stTile;
     struct stIsland;
+    struct stRegion;
+    struct stLayer;
 
-    stMaterial* material(int16_t handle);
-    stMaterial& material(int16_t& handle, bool dynamic);
+    stMaterial material(int32_t handle) const;
+    void material(int32_t& handle, stMaterial const& definition);
 
-    stBehavior* behavior(int16_t handle);
-    stBehavior& behavior(int16_t& handle, bool dynamic);
+    stBehavior behavior(int32_t handle) const;
+    int32_t behave();
 
     stIsland* island(int32_t altitude, int32_t x, int32_t y);
     stIsland* island(int32_t altitude, float x, float y);
+    stIsland* attach(int32_t handle, stKey const& key);
+    void place(stIsland* island, int32_t material, stRequest const& request);
+
+    stRegion* region(int32_t altitude, int32_t x, int32_t y);
+    stLayer& layer(int32_t altitude);
+
+    template<class Function> void each(stBounds const& bounds, Function&& function);
+
+    int32_t diffuse();
+    void activate(stIsland* island);
+    void expire(stIsland* island);
+    void wake(stIsland* island);
+    static void halo(stIsland const* island, int16_t* grid, int16_t* live);
+
+    void release(stTile const& tile);
+    void release(stIsland* island);
+    void release(stRegion* region);
+
+    template<class Struct> static void insert(std::vector<Struct*>& ordered, Struct* element);
+    template<class Struct> static void erase(std::vector<Struct*>& ordered, Struct* element);
+
+    static stKey locate(stLocation const& location);
+    static int32_t snap(int32_t value, int32_t unit);
 
     std::string const m_guid;
     std::string const m_directory;
 
-    std::vector<stMaterial*> m_materials;
-    std::vector<stIsland*> m_islands;
+    std::vector<int32_t> m_materials;
+    std::vector<int32_t> m_destroyed;
+    std::vector<int32_t> m_active;
+    std::vector<stLayer> m_layers;
+
+    stTable<stLabel, int32_t> m_materialsTable;
+    stTable<stKey, stIsland*> m_islandsTable;
+    stTable<stKey, stRegion*> m_regionsTable;
+    stWheel<int32_t> m_islandsWheel;
+    std::unique_ptr<stWorkers> m_workers;
+    bool m_compacting;
 
-    stPool<stMaterial> m_materialsPool;
-    stPool<stBehavior> m_behaviorsPool;
+    stMaterials m_materialsStore;
+    stBehaviors m_behaviorsStore;
     stPool<stIsland> m_islandsPool;
+    stPool<stRegion> m_regionsPool;
 };
 
 #endif // SUBTILE_SUBTILE_H
@@ -265,10 +265,13 @@ int main()
     {
         stUI ui;
         stSubtile os("universe");
+        stScheduler scheduler(stSettings::RateStep, stSettings::BudgetStep, stSettings::BacklogStep);
         os.parse(stRequest(0, 2.0f, -1.0f));
 
         while(ui.step())
         {
+            scheduler.advance(ui.delta(), [&os]() { os.step(); });
+
             stSubtileMesh mesh;
             os.visit(mesh, stBounds(stLocation(0, -2.0f, -2.0f), stLocation(0, 2.0f, 2.0f)));
             ui.draw(mesh);